@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+"""
+Content-addressed firmware artifact cache for ESP32 builds.
+Build outputs (.bin/.elf/.map, flasher_args.json, flash_args and the size reports)
+are stored under a key hashing every build input: app, build type, target, ESP-IDF
+version and commit, toolchain, sdkconfig inputs and the source tree. build_app.sh
+restores from the cache instead of compiling and flash_app.sh fetches from it before
+auto-building. The store is kept under a size budget with LRU eviction.
+"""
+
+import os
+import re
+import sys
+import json
+import time
+import shutil
+import hashlib
+import functools
+import argparse
+import subprocess
+import tempfile
+from pathlib import Path
+
+# Bump when the key inputs or the entry layout change
+CACHE_FORMAT = 2
+
+DEFAULT_CACHE_DIR = Path.home() / ".cache" / "esp32-artifacts"
+DEFAULT_MAX_SIZE = "5G"
+
+# Exit code of restore when the key is not in the cache
+EXIT_MISS = 3
+
+# Build directory files stored besides the flash_files listed in flasher_args.json
+ARTIFACT_PATTERNS = [
+    "{project}.bin", "{project}.elf", "{project}.map",
+    "flasher_args.json", "flash_args", "flash_app_args", "flash_bootloader_args",
+    "flash_project_args", "project_description.json",
+    "size.txt", "size.json", "size_report.json", "size_components.txt", "size_components.json",
+    "size_symbols.txt", "size_symbols.json", "size.cache",
+]
+
+# Directories never hashed as part of the source tree
+SKIP_DIRS = {".git", "logs", "managed_components", "__pycache__", ".cache"}
+# Build trees: "build", the build_directory_pattern directories and the shared trees
+# (any other directory holding a CMakeCache.txt is a build tree as well)
+BUILD_DIR_RE = re.compile(r"build|build-app-.+|build-shared-.+")
+# Backup that menuconfig and every configure rewrite (sdkconfig itself is a key input)
+SKIP_FILES = {"sdkconfig.old"}
+
+MANIFEST_NAME = "manifest.json"
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Firmware Artifact Cache")
+    print("")
+    print("Usage: python3 artifact_cache.py <command> [OPTIONS]")
+    print("")
+    print("COMMANDS:")
+    print("  key                         - Print the cache key of a build and its inputs")
+    print("  restore <build_dir>         - Restore cached artifacts; prints the key, exit 3 on a miss")
+    print("  store <build_dir>           - Store the artifacts of a finished build, then evict")
+    print("  list                        - List cached entries (most recently used first)")
+    print("  stats                       - Show cache size and entry count")
+    print("  evict                       - Evict least recently used entries down to --max-size")
+    print("  clear                       - Remove every cached entry")
+    print("")
+    print("BUILD OPTIONS (key, restore, store):")
+    print("  --app <app>                 - Application type")
+    print("  --build-type <type>         - Build type")
+    print("  --target <target>           - IDF target")
+    print("  --idf-version <version>     - ESP-IDF version")
+    print("  --idf-path <path>           - ESP-IDF checkout (commit is part of the key)")
+    print("  --project-dir <path>        - Project directory (sdkconfig and source tree)")
+    print("  --project-name <name>       - Project name (<name>.bin/.elf/.map)")
+    print("  --key <key>                 - Use a key computed earlier (store after a build)")
+    print("")
+    print("CACHE OPTIONS:")
+    print(f"  --cache-dir <path>          - Store location (default: $ESP32_ARTIFACT_CACHE_DIR or {DEFAULT_CACHE_DIR})")
+    print(f"  --max-size <size>           - Size budget such as 5G or 500M (default: {DEFAULT_MAX_SIZE})")
+    print("  --help, -h                  - Show this help message")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 artifact_cache.py stats")
+    print("  python3 artifact_cache.py key --app gpio_test --build-type Release --target esp32c6 \\")
+    print("      --idf-version release/v5.5 --idf-path $IDF_PATH --project-dir ..")
+    print("  python3 artifact_cache.py evict --max-size 2G")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Content-addressed firmware artifact cache",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("command", nargs="?", choices=["key", "restore", "store", "list", "stats", "evict", "clear"])
+    parser.add_argument("build_dir", nargs="?", help="Build directory (restore, store)")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--app", help="Application type")
+    parser.add_argument("--build-type", help="Build type")
+    parser.add_argument("--target", help="IDF target")
+    parser.add_argument("--idf-version", default="", help="ESP-IDF version")
+    parser.add_argument("--idf-path", default="", help="ESP-IDF checkout")
+    parser.add_argument("--project-dir", help="Project directory")
+    parser.add_argument("--project-name", help="Project name")
+    parser.add_argument("--key", help="Precomputed cache key")
+    parser.add_argument("--cache-dir", default=os.environ.get("ESP32_ARTIFACT_CACHE_DIR", str(DEFAULT_CACHE_DIR)),
+                        help="Cache directory")
+    parser.add_argument("--max-size", default=os.environ.get("ESP32_ARTIFACT_CACHE_SIZE", DEFAULT_MAX_SIZE),
+                        help="Size budget")
+
+    args = parser.parse_args()
+
+    if args.help or not args.command:
+        show_help()
+
+    return args
+
+def parse_size(value):
+    """Convert 5G / 500M / 1024K / plain bytes to bytes."""
+    match = re.fullmatch(r'\s*(\d+)\s*([KMGT]?)B?\s*', str(value), re.IGNORECASE)
+    if not match:
+        raise ValueError(f"invalid size: {value}")
+    return int(match.group(1)) * 1024 ** " KMGT".index(match.group(2).upper() or " ")
+
+def run_git(cwd, *args):
+    """Run git and return its stdout (None when git or the repository is unavailable)."""
+    try:
+        result = subprocess.run(["git", "-C", str(cwd), *args], capture_output=True, check=True)
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    return result.stdout
+
+def file_sha256(path):
+    """SHA-256 of a file, read in chunks."""
+    digest = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+@functools.lru_cache(maxsize=None)
+def is_build_tree(path):
+    """A build directory by name, or any directory CMake configured."""
+    return bool(BUILD_DIR_RE.fullmatch(path.name)) or (path / "CMakeCache.txt").is_file()
+
+def is_skipped(root, relative_path):
+    """Build trees, logs, sdkconfig.old and VCS metadata are outputs, not inputs."""
+    parts = Path(relative_path).parts
+    if parts[-1] in SKIP_FILES or parts[-1].startswith(".app_config.snapshot"):
+        return True
+    directory = root
+    for part in parts[:-1]:
+        directory = directory / part
+        if part in SKIP_DIRS or is_build_tree(directory):
+            return True
+    return False
+
+def source_tree_hash(project_dir):
+    """Hash the contents of every source file of the project's repository."""
+    root = project_dir
+    toplevel = run_git(project_dir, "rev-parse", "--show-toplevel")
+    if toplevel:
+        root = Path(toplevel.decode().strip())
+        listing = run_git(root, "ls-files", "-z", "--cached", "--others", "--exclude-standard")
+        files = sorted(set(name for name in listing.decode(errors='replace').split('\0') if name)) if listing else []
+    else:
+        files = []
+        for directory, dirnames, filenames in os.walk(project_dir):
+            dirnames[:] = [d for d in dirnames if d not in SKIP_DIRS and not is_build_tree(Path(directory, d))]
+            for filename in filenames:
+                files.append(os.path.relpath(os.path.join(directory, filename), project_dir))
+        files.sort()
+
+    digest = hashlib.sha256()
+    count = 0
+    for relative_path in files:
+        if is_skipped(root, relative_path):
+            continue
+        path = root / relative_path
+        if not path.is_file():
+            continue  # Deleted but still in the index, or a submodule
+        digest.update(relative_path.encode() + b'\0' + file_sha256(path).encode() + b'\n')
+        count += 1
+    return digest.hexdigest(), count
+
+def toolchain_id(target):
+    """Toolchain identity that is stable across machines (version directory, not home path)."""
+    compiler = f"xtensa-{target}-elf-gcc" if target in ("esp32", "esp32s2", "esp32s3") else "riscv32-esp-elf-gcc"
+    path = shutil.which(compiler)
+    if not path:
+        return "none"
+    match = re.search(r'tools/[^/]+/([^/]+)/', str(Path(path).resolve()))
+    return f"{compiler}@{match.group(1)}" if match else f"{compiler}@{path}"
+
+def compute_key(args):
+    """Hash every build input into the cache key."""
+    for option in ("app", "build_type", "target", "project_dir"):
+        if not getattr(args, option):
+            raise ValueError(f"--{option.replace('_', '-')} is required")
+
+    project_dir = Path(args.project_dir).resolve()
+    idf_commit = "unknown"
+    if args.idf_path:
+        output = run_git(args.idf_path, "rev-parse", "HEAD")
+        if output:
+            idf_commit = output.decode().strip()
+
+    # sdkconfig as it is before configure: menuconfig changes live only there
+    sdkconfig = {}
+    for path in sorted(project_dir.glob("sdkconfig*")):
+        if path.name in SKIP_FILES:
+            continue
+        if path.is_file():
+            sdkconfig[path.name] = file_sha256(path)
+
+    tree_hash, tree_files = source_tree_hash(project_dir)
+    inputs = {
+        'format': CACHE_FORMAT,
+        'app': args.app,
+        'build_type': args.build_type,
+        'target': args.target,
+        'idf_version': args.idf_version,
+        'idf_commit': idf_commit,
+        'toolchain': toolchain_id(args.target),
+        'sdkconfig': sdkconfig,
+        'source_tree': tree_hash,
+        'source_files': tree_files,
+    }
+    key = hashlib.sha256(json.dumps(inputs, sort_keys=True).encode()).hexdigest()
+    return key, inputs
+
+def entry_dir(cache_dir, key):
+    return cache_dir / "objects" / key[:2] / key
+
+def collect_artifacts(build_dir, project_name):
+    """Relative paths of the artifacts to store from a build directory."""
+    files = [pattern.format(project=project_name) for pattern in ARTIFACT_PATTERNS]
+    try:
+        with open(build_dir / "flasher_args.json") as f:
+            files += list((json.load(f).get('flash_files') or {}).values())
+    except (OSError, ValueError):
+        pass
+    return sorted(set(name for name in files if (build_dir / name).is_file()))
+
+def entries(cache_dir):
+    """All complete entries with their manifest, size and last use time."""
+    result = []
+    for manifest_file in (cache_dir / "objects").glob(f"*/*/{MANIFEST_NAME}"):
+        try:
+            manifest = json.loads(manifest_file.read_text())
+            last_used = manifest_file.stat().st_mtime
+        except (OSError, ValueError):
+            continue
+        result.append({'dir': manifest_file.parent, 'manifest': manifest,
+                       'size': manifest.get('size', 0), 'last_used': last_used})
+    return result
+
+def restore(args, cache_dir):
+    """Copy a cached entry into the build directory (exit EXIT_MISS when absent)."""
+    key = args.key or compute_key(args)[0]
+    print(key)
+    entry = entry_dir(cache_dir, key)
+    manifest_file = entry / MANIFEST_NAME
+    if not manifest_file.is_file():
+        return EXIT_MISS
+
+    build_dir = Path(args.build_dir)
+    manifest = json.loads(manifest_file.read_text())
+    for name in manifest['files']:
+        destination = build_dir / name
+        destination.parent.mkdir(parents=True, exist_ok=True)
+        shutil.copy2(entry / "files" / name, destination)
+    # The manifest mtime is the LRU timestamp
+    os.utime(manifest_file)
+    print(f"Restored {len(manifest['files'])} artifacts from the cache ({manifest['app']} "
+          f"{manifest['build_type']}, stored {time.ctime(manifest['created'])})", file=sys.stderr)
+    return 0
+
+def store(args, cache_dir):
+    """Copy a finished build's artifacts into the cache, then enforce the size budget."""
+    if not args.project_name:
+        raise ValueError("--project-name is required")
+    key, inputs = (args.key, None) if args.key else compute_key(args)
+    entry = entry_dir(cache_dir, key)
+    if (entry / MANIFEST_NAME).is_file():
+        os.utime(entry / MANIFEST_NAME)
+        return 0
+
+    build_dir = Path(args.build_dir)
+    files = collect_artifacts(build_dir, args.project_name)
+    if not any(name.endswith(".bin") for name in files):
+        raise ValueError(f"no firmware binary found in {build_dir}")
+
+    # Assemble the entry next to its final location and move it into place atomically
+    entry.parent.mkdir(parents=True, exist_ok=True)
+    staging = Path(tempfile.mkdtemp(prefix=f".{key}.", dir=entry.parent))
+    try:
+        size = 0
+        for name in files:
+            destination = staging / "files" / name
+            destination.parent.mkdir(parents=True, exist_ok=True)
+            shutil.copy2(build_dir / name, destination)
+            size += destination.stat().st_size
+        (staging / MANIFEST_NAME).write_text(json.dumps({
+            'key': key,
+            'app': args.app,
+            'build_type': args.build_type,
+            'target': args.target,
+            'idf_version': args.idf_version,
+            'project_name': args.project_name,
+            'created': time.time(),
+            'size': size,
+            'files': files,
+            'inputs': inputs,
+        }, indent=2) + "\n")
+        os.rename(staging, entry)
+    except OSError:
+        shutil.rmtree(staging, ignore_errors=True)
+        if not (entry / MANIFEST_NAME).is_file():
+            raise
+        # A concurrent build stored the same key first
+    print(f"Stored {len(files)} artifacts in the cache ({size / 1024:.0f} KiB)", file=sys.stderr)
+    evict(cache_dir, parse_size(args.max_size))
+    return 0
+
+def evict(cache_dir, max_size):
+    """Remove least recently used entries until the store fits the budget."""
+    all_entries = sorted(entries(cache_dir), key=lambda e: e['last_used'])
+    total = sum(e['size'] for e in all_entries)
+    evicted = 0
+    for entry in all_entries:
+        if total <= max_size:
+            break
+        shutil.rmtree(entry['dir'], ignore_errors=True)
+        total -= entry['size']
+        evicted += 1
+    if evicted:
+        print(f"Evicted {evicted} least recently used cache entries", file=sys.stderr)
+    return total
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    cache_dir = Path(args.cache_dir).expanduser()
+
+    try:
+        if args.command in ("restore", "store") and not args.build_dir:
+            raise ValueError(f"{args.command} needs a build directory")
+
+        if args.command == "key":
+            key, inputs = compute_key(args)
+            print(key)
+            print(json.dumps(inputs, indent=2), file=sys.stderr)
+        elif args.command == "restore":
+            sys.exit(restore(args, cache_dir))
+        elif args.command == "store":
+            store(args, cache_dir)
+        elif args.command == "list":
+            for entry in sorted(entries(cache_dir), key=lambda e: -e['last_used']):
+                manifest = entry['manifest']
+                print(f"{manifest['key'][:16]}  {time.strftime('%Y-%m-%d %H:%M', time.localtime(entry['last_used']))}"
+                      f"  {entry['size'] / 1024:>8.0f} KiB  {manifest['app']} {manifest['build_type']}"
+                      f" {manifest['target']} {manifest['idf_version']}")
+        elif args.command == "stats":
+            all_entries = entries(cache_dir)
+            total = sum(e['size'] for e in all_entries)
+            print(f"Cache directory: {cache_dir}")
+            print(f"Entries: {len(all_entries)}")
+            print(f"Size: {total / 1024 / 1024:.1f} MiB of {parse_size(args.max_size) / 1024 / 1024:.0f} MiB")
+        elif args.command == "evict":
+            evict(cache_dir, parse_size(args.max_size))
+        elif args.command == "clear":
+            shutil.rmtree(cache_dir / "objects", ignore_errors=True)
+            print(f"Cleared {cache_dir}")
+    except (OSError, ValueError, KeyError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,464 @@
+#!/usr/bin/env python3
+"""
+Startup-latency and process-spawn benchmark for the ESP32 script layer.
+Runs every script entry point against synthetic app_config.yml files (10, 100
+and 1000 apps by default) with stub idf.py/yq/esptool binaries, so it works
+offline and never touches real hardware or a real ESP-IDF installation.
+Results are written as JSON and can be compared against a baseline with a
+regression threshold, so config_loader.sh overhead regressions fail CI early.
+"""
+
+import os
+import re
+import sys
+import json
+import stat
+import time
+import shutil
+import argparse
+import platform
+import tempfile
+import statistics
+import subprocess
+from pathlib import Path
+
+import yaml
+
+# Scripts live one level above this benchmark directory
+SCRIPTS_DIR = Path(__file__).resolve().parent.parent
+
+RESULTS_FORMAT = 1
+DEFAULT_APP_COUNTS = [10, 100, 1000]
+DEFAULT_RUNS = 5
+DEFAULT_THRESHOLD = 0.20       # 20% slower than baseline counts as a regression
+DEFAULT_MIN_DELTA_MS = 10.0    # ...but only when it is also at least this many ms slower
+DEFAULT_MODES = ["snapshot"]
+RUN_TIMEOUT_S = 600            # A single run taking longer than this is reported as exit code -1
+
+IDF_VERSIONS = ["release/v5.5", "release/v5.4"]
+BUILD_DIRECTORY_PATTERN = "build-app-{app_type}-type-{build_type}-target-{target}-idf-{idf_version}"
+PROJECT_NAME_PATTERN = "esp32_iid_{app_type}_app"
+TARGET = "esp32c6"
+LOG_FILE_COUNT = 25
+
+# Entry points: name -> argv relative to the synthetic project (APP is substituted)
+ENTRY_POINTS = {
+    "build_app.sh list": ["bash", "scripts/build_app.sh", "list"],
+    "build_app.sh info": ["bash", "scripts/build_app.sh", "info", "{app}"],
+    "build_app.sh combinations": ["bash", "scripts/build_app.sh", "combinations"],
+    "build_app.sh validate": ["bash", "scripts/build_app.sh", "validate", "{app}", "Release"],
+    "flash_app.sh size": ["bash", "scripts/flash_app.sh", "size", "{app}", "Release"],
+    "generate_matrix.py": [sys.executable, "scripts/generate_matrix.py", "--project-path", "."],
+    "get_app_info.py list": [sys.executable, "scripts/get_app_info.py", "list", "--project-path", "."],
+    "manage_logs.sh stats": ["bash", "scripts/manage_logs.sh", "stats"],
+}
+
+# Stub tools put first on PATH. Each call is appended to $BENCH_STUB_LOG.
+STUB_TEMPLATE = """#!/bin/sh
+echo "{name}" >> "${{BENCH_STUB_LOG:-/dev/null}}"
+{body}
+"""
+STUB_BODIES = {
+    "idf.py": 'echo "stub idf.py $*"\nexit 0',
+    "esptool.py": 'echo "stub esptool.py $*"\nexit 0',
+    "esptool": 'echo "stub esptool $*"\nexit 0',
+    # yq is only reached when the config snapshot is unavailable; delegate to a
+    # local yq (no network involved) so the yq mode still measures real work
+    "yq": 'if [ -n "$BENCH_REAL_YQ" ]; then exec "$BENCH_REAL_YQ" "$@"; fi\n'
+          'echo "yq stub: no local yq available" >&2\nexit 1',
+}
+
+# Linker map of the pre-built fixture, so `flash_app.sh size` measures the cached size report
+STUB_MAP = """Memory Configuration
+
+Name             Origin             Length             Attributes
+iram0_0_seg      0x40800000         0x00050000         xrw
+irom_seg         0x42000020         0x007fffe0         xr
+dram0_0_seg      0x40810000         0x00040000         rw
+*default*        0x00000000         0xffffffff
+
+Linker script and memory map
+
+.iram0.text     0x40800000      0x100
+ .iram1.0       0x40800000      0x100 esp-idf/freertos/libfreertos.a(port.c.obj)
+                0x40800000                vPortYield
+
+.flash.text     0x42000020     0x2000
+ .text.app_main 0x42000020     0x2000 esp-idf/main/libmain.a(main.cpp.obj)
+                0x42000020                app_main
+
+.dram0.bss      0x40810000      0x400
+ COMMON         0x40810000      0x400 esp-idf/freertos/libfreertos.a(tasks.c.obj)
+"""
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Script Startup Benchmark")
+    print("")
+    print("Usage: python3 benchmarks/bench_scripts.py [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --apps <n,n,...>            - Synthetic config sizes (default: 10,100,1000)")
+    print("  --runs <n>                  - Timed runs per entry point (default: 5)")
+    print("  --entry <name>              - Only run entry points containing <name> (repeatable)")
+    print("  --modes <m,m>               - Config modes: snapshot, yq (default: snapshot)")
+    print("  --output <file>             - Write JSON results to file (default: stdout)")
+    print("  --baseline <file>           - Compare against a previous results file")
+    print("  --threshold <ratio>         - Allowed slowdown vs baseline (default: 0.20)")
+    print("  --min-delta-ms <ms>         - Ignore slowdowns smaller than this (default: 10)")
+    print("  --keep-workdir              - Keep the synthetic projects for inspection")
+    print("")
+    print("MEASUREMENTS (per entry point, config size and mode):")
+    print("  • wall_ms: min/median/mean of the timed runs, plus the cold first run")
+    print("  • forks/execs: process spawns (strace when available, else /proc/stat delta)")
+    print("  • stub_calls: how often idf.py, yq and esptool stubs were invoked")
+    print("")
+    print("REGRESSIONS:")
+    print("  • A median wall time above baseline * (1 + threshold) and min-delta-ms fails")
+    print("  • More forks than baseline * (1 + threshold) fails (strace counts only)")
+    print("  • Exit code 1 when any regression is found or a benchmarked command fails")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 benchmarks/bench_scripts.py --output baseline.json")
+    print("  python3 benchmarks/bench_scripts.py --baseline baseline.json --output current.json")
+    print("  python3 benchmarks/bench_scripts.py --apps 100 --entry build_app --modes snapshot,yq")
+    print("")
+    print("For detailed information, see: docs/README_UTILITY_SCRIPTS.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Benchmark startup latency and process spawns of the ESP32 scripts",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--apps", default=",".join(str(n) for n in DEFAULT_APP_COUNTS), help="Config sizes")
+    parser.add_argument("--runs", type=int, default=DEFAULT_RUNS, help="Timed runs per entry point")
+    parser.add_argument("--entry", action="append", default=[], help="Entry point filter")
+    parser.add_argument("--modes", default=",".join(DEFAULT_MODES), help="Config modes")
+    parser.add_argument("--output", "-o", help="Output file path")
+    parser.add_argument("--baseline", help="Baseline results file")
+    parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD, help="Regression threshold")
+    parser.add_argument("--min-delta-ms", type=float, default=DEFAULT_MIN_DELTA_MS, help="Minimum slowdown")
+    parser.add_argument("--keep-workdir", action="store_true", help="Keep synthetic projects")
+
+    args = parser.parse_args()
+
+    if args.help:
+        show_help()
+
+    return args
+
+def synthetic_config(app_count):
+    """Build an app_config.yml exercising every override style."""
+    apps = {}
+    for i in range(app_count):
+        app = {
+            'description': f"Synthetic benchmark app {i}",
+            'source_file': f"SyntheticApp{i:04d}.cpp",
+            'category': "benchmark",
+            'ci_enabled': i % 4 != 3,
+            'featured': i % 10 == 0,
+        }
+        if i % 5 == 1:
+            # Nested per-IDF-version build types
+            app['idf_versions'] = list(IDF_VERSIONS)
+            app['build_types'] = [["Debug", "Release"], ["Debug"]]
+        elif i % 3 == 2:
+            # Flat build types for every IDF version
+            app['build_types'] = ["Debug", "Release"]
+        if i % 7 == 6:
+            app['target'] = "esp32s3"
+        apps[f"app_{i:04d}"] = app
+
+    return {
+        'metadata': {
+            'project': "Benchmark Project",
+            'default_app': "app_0000",
+            'default_build_type': "Release",
+            'target': TARGET,
+            'idf_versions': list(IDF_VERSIONS),
+            'build_types': [["Debug", "Release"], ["Debug"]],
+        },
+        'apps': apps,
+        'build_config': {
+            'build_directory_pattern': BUILD_DIRECTORY_PATTERN,
+            'project_name_pattern': PROJECT_NAME_PATTERN,
+        },
+        'ci_config': {
+            'exclude_combinations': [{'app_name': "app_0003", 'build_type': "Debug"}],
+        },
+    }
+
+def write_stubs(stub_dir):
+    """Create the stub tool binaries."""
+    stub_dir.mkdir(parents=True, exist_ok=True)
+    for name, body in STUB_BODIES.items():
+        path = stub_dir / name
+        path.write_text(STUB_TEMPLATE.format(name=name, body=body))
+        path.chmod(path.stat().st_mode | stat.S_IXUSR | stat.S_IXGRP | stat.S_IXOTH)
+
+def create_project(root, app_count):
+    """Create a synthetic project: config, scripts link, logs and a fake build."""
+    project = root / f"project_{app_count}"
+    project.mkdir(parents=True)
+    (project / "app_config.yml").write_text(yaml.safe_dump(synthetic_config(app_count), sort_keys=False))
+    # Scripts locate the project as the parent of their own directory
+    (project / "scripts").symlink_to(SCRIPTS_DIR, target_is_directory=True)
+
+    logs = project / "logs"
+    logs.mkdir()
+    for i in range(LOG_FILE_COUNT):
+        (logs / f"app_{i:04d}_Release_20240101_{i:06d}.log").write_text(
+            "".join(f"I ({n}) synthetic: line {n}\n" for n in range(200)) + "E (1) synthetic: error\n")
+
+    # Pre-built output for `flash_app.sh size app_0000 Release`
+    build_dir = project / BUILD_DIRECTORY_PATTERN.format(
+        app_type="app_0000", build_type="Release", target=TARGET,
+        idf_version=IDF_VERSIONS[0].replace('/', '_').replace('.', '_'))
+    build_dir.mkdir()
+    project_name = PROJECT_NAME_PATTERN.format(app_type="app_0000")
+    (build_dir / f"{project_name}.bin").write_bytes(b"\0" * 1024)
+    (build_dir / f"{project_name}.elf").write_bytes(b"\x7fELF" + b"\0" * 1020)
+    (build_dir / f"{project_name}.map").write_text(STUB_MAP)
+    return project
+
+def spawn_method():
+    """Pick the most accurate process-spawn counter available."""
+    if shutil.which("strace"):
+        return "strace"
+    if Path("/proc/stat").exists():
+        return "proc_stat"
+    return "none"
+
+def proc_stat_forks():
+    """Total forks since boot (system-wide, so only an approximation)."""
+    with open("/proc/stat") as f:
+        for line in f:
+            if line.startswith("processes "):
+                return int(line.split()[1])
+    return 0
+
+STRACE_SPAWN = re.compile(r'\b(clone3?|v?fork)\(')
+STRACE_EXEC = re.compile(r'\bexecve\(.*\)\s*=\s*0\b')
+
+def count_spawns(argv, env, cwd, method):
+    """Run argv once and count forks and execs."""
+    if method == "strace":
+        with tempfile.NamedTemporaryFile(prefix="bench_strace.", delete=False) as tmp:
+            trace_file = tmp.name
+        try:
+            subprocess.run(["strace", "-f", "-qq", "-e", "trace=clone,clone3,fork,vfork,execve",
+                            "-o", trace_file] + argv,
+                           cwd=cwd, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            forks = execs = 0
+            with open(trace_file) as f:
+                for line in f:
+                    # Threads are not process spawns
+                    if STRACE_SPAWN.search(line) and "CLONE_THREAD" not in line and "= -" not in line:
+                        forks += 1
+                    elif STRACE_EXEC.search(line):
+                        execs += 1
+            return forks, execs
+        finally:
+            os.unlink(trace_file)
+
+    if method == "proc_stat":
+        before = proc_stat_forks()
+        subprocess.run(argv, cwd=cwd, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        # Subtract the fork of the benchmarked process itself
+        return proc_stat_forks() - before - 1, None
+
+    return None, None
+
+def run_timed(argv, env, cwd):
+    """Run argv once and return (wall_ms, exit_code)."""
+    start = time.perf_counter()
+    try:
+        proc = subprocess.run(argv, cwd=cwd, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                              timeout=RUN_TIMEOUT_S)
+        exit_code = proc.returncode
+    except subprocess.TimeoutExpired:
+        exit_code = -1
+    return (time.perf_counter() - start) * 1000.0, exit_code
+
+def stub_calls(stub_log):
+    """Count stub invocations recorded in the stub log, then reset it."""
+    counts = {name: 0 for name in STUB_BODIES}
+    if stub_log.exists():
+        for line in stub_log.read_text().splitlines():
+            counts[line] = counts.get(line, 0) + 1
+        stub_log.unlink()
+    return counts
+
+def clear_snapshot(project):
+    """Remove the compiled config snapshot so the cold run includes compilation."""
+    for snapshot in project.glob(".app_config.snapshot.*"):
+        snapshot.unlink()
+
+def benchmark_entry(name, argv, project, env, runs, method, stub_log):
+    """Measure one entry point against one project."""
+    clear_snapshot(project)
+    cold_ms, exit_code = run_timed(argv, env, project)
+    stub_calls(stub_log)
+
+    # A failing run times an error path: report the first non-zero exit code
+    samples = []
+    for _ in range(runs):
+        wall_ms, run_exit_code = run_timed(argv, env, project)
+        samples.append(wall_ms)
+        if exit_code == 0:
+            exit_code = run_exit_code
+    calls = stub_calls(stub_log)
+    # Stub calls are per run, the timed loop ran `runs` times
+    calls = {k: v // max(runs, 1) for k, v in calls.items()}
+
+    forks, execs = count_spawns(argv, env, project, method)
+    stub_calls(stub_log)
+
+    return {
+        'wall_ms': {
+            'cold': round(cold_ms, 2),
+            'min': round(min(samples), 2),
+            'median': round(statistics.median(samples), 2),
+            'mean': round(statistics.mean(samples), 2),
+        },
+        'forks': forks,
+        'execs': execs,
+        'stub_calls': calls,
+        'exit_code': exit_code,
+    }
+
+def compare_with_baseline(results, baseline, threshold, min_delta_ms):
+    """Return a list of human-readable regressions against the baseline."""
+    def key(entry):
+        return (entry['entry'], entry['apps'], entry['mode'])
+
+    baseline_entries = {key(e): e for e in baseline.get('results', [])}
+    same_method = baseline.get('spawn_method') == results['spawn_method'] == "strace"
+    regressions = []
+
+    for entry in results['results']:
+        base = baseline_entries.get(key(entry))
+        if not base:
+            continue
+        label = f"{entry['entry']} ({entry['apps']} apps, {entry['mode']})"
+
+        current_ms = entry['wall_ms']['median']
+        base_ms = base['wall_ms']['median']
+        if current_ms > base_ms * (1 + threshold) and current_ms - base_ms >= min_delta_ms:
+            regressions.append(f"{label}: median {current_ms:.1f} ms vs baseline {base_ms:.1f} ms")
+
+        if same_method and entry['forks'] is not None and base.get('forks') is not None:
+            if entry['forks'] > base['forks'] * (1 + threshold):
+                regressions.append(f"{label}: {entry['forks']} forks vs baseline {base['forks']}")
+
+        if entry['exit_code'] != base.get('exit_code', entry['exit_code']):
+            regressions.append(f"{label}: exit code {entry['exit_code']} vs baseline {base['exit_code']}")
+
+    return regressions
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    app_counts = [int(n) for n in args.apps.split(",") if n.strip()]
+    modes = [m.strip() for m in args.modes.split(",") if m.strip()]
+    for mode in modes:
+        if mode not in ("snapshot", "yq"):
+            print(f"Error: Unknown mode: {mode}", file=sys.stderr)
+            sys.exit(1)
+
+    entries = {name: argv for name, argv in ENTRY_POINTS.items()
+               if not args.entry or any(f in name for f in args.entry)}
+    if not entries:
+        print("Error: No entry points match the --entry filter", file=sys.stderr)
+        sys.exit(1)
+
+    method = spawn_method()
+    workdir = Path(tempfile.mkdtemp(prefix="esp32_script_bench."))
+    stub_dir = workdir / "stubs"
+    stub_log = workdir / "stub_calls.log"
+    write_stubs(stub_dir)
+
+    real_yq = shutil.which("yq") or ""
+    base_env = dict(os.environ)
+    for var in ("PROJECT_PATH", "CONFIG_SNAPSHOT", "YQ_WARNING_SHOWN", "YQ_SYNTAX"):
+        base_env.pop(var, None)
+    base_env.update({
+        'PATH': f"{stub_dir}{os.pathsep}{os.environ.get('PATH', '')}",
+        'IDF_PATH': str(workdir / "esp-idf-stub"),
+        'BENCH_STUB_LOG': str(stub_log),
+        'BENCH_REAL_YQ': real_yq,
+    })
+
+    results = {
+        'format': RESULTS_FORMAT,
+        'timestamp': time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        'host': {
+            'platform': platform.platform(),
+            'python': platform.python_version(),
+            'cpus': os.cpu_count(),
+        },
+        'spawn_method': method,
+        'runs': args.runs,
+        'results': [],
+    }
+
+    try:
+        for app_count in app_counts:
+            project = create_project(workdir, app_count)
+            for mode in modes:
+                env = dict(base_env)
+                env['CONFIG_SNAPSHOT'] = "1" if mode == "snapshot" else "0"
+                for name, argv in entries.items():
+                    argv = [arg.format(app="app_0000") for arg in argv]
+                    print(f"Benchmarking {name} ({app_count} apps, {mode})...", file=sys.stderr)
+                    measurement = benchmark_entry(name, argv, project, env, args.runs, method, stub_log)
+                    results['results'].append({'entry': name, 'apps': app_count, 'mode': mode, **measurement})
+    finally:
+        if args.keep_workdir:
+            print(f"Synthetic projects kept in {workdir}", file=sys.stderr)
+        else:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+    regressions = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare_with_baseline(results, baseline, args.threshold, args.min_delta_ms)
+        results['baseline'] = {
+            'file': args.baseline,
+            'threshold': args.threshold,
+            'min_delta_ms': args.min_delta_ms,
+            'regressions': regressions,
+        }
+
+    output = json.dumps(results, indent=2)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(output + "\n")
+        print(f"Results written to {args.output}", file=sys.stderr)
+    else:
+        print(output)
+
+    failures = [entry for entry in results['results'] if entry['exit_code'] != 0]
+    if failures:
+        print("Benchmarked commands failed (their timings measure an error path):", file=sys.stderr)
+        for entry in failures:
+            print(f"  {entry['entry']} ({entry['apps']} apps, {entry['mode']}): exit code {entry['exit_code']}",
+                  file=sys.stderr)
+
+    if regressions:
+        print("Performance regressions detected:", file=sys.stderr)
+        for regression in regressions:
+            print(f"  {regression}", file=sys.stderr)
+
+    if failures or regressions:
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
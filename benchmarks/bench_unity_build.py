@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+Clean-build benchmark of the unity (jumbo) build against the normal build.
+Builds one app from scratch with a normal build type (default Release) and a
+unity build type (default Unity, see build_config.build_types in app_config.yml)
+through build_app.sh, with ccache, the artifact cache and the shared component
+build disabled so every run compiles everything. Reports wall time, compile
+edges and CPU time from build_profile.json and the image and memory sizes
+from size_report.json, plus the difference of the unity build against the normal one.
+"""
+
+import os
+import re
+import sys
+import json
+import time
+import argparse
+import platform
+import statistics
+import subprocess
+from pathlib import Path
+
+# Scripts live one level above this benchmark directory (symlinks kept: the project is the
+# directory the scripts are linked into)
+SCRIPTS_DIR = Path(__file__).absolute().parent.parent
+
+RESULTS_FORMAT = 1
+DEFAULT_NORMAL_TYPE = "Release"
+DEFAULT_UNITY_TYPE = "Unity"
+DEFAULT_RUNS = 1
+
+# Every run is a full compile: nothing may be restored or shared between runs
+BUILD_OPTIONS = ["--clean", "--no-cache", "--no-artifact-cache", "--no-shared-build", "--no-clone"]
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Unity Build Benchmark")
+    print("")
+    print("Usage: python3 benchmarks/bench_unity_build.py <app> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --normal <build_type>       - Build type of the normal build (default: Release)")
+    print("  --unity <build_type>        - Build type with unity_build: true (default: Unity)")
+    print("  --idf-version <version>     - ESP-IDF version (default: smart default of build_app.sh)")
+    print("  --runs <n>                  - Clean builds per build type (default: 1)")
+    print("  --project-path <path>       - Project directory (default: parent of the scripts)")
+    print("  --output <file>             - Write JSON results to file (default: stdout)")
+    print("")
+    print("MEASUREMENTS (per build type):")
+    print("  • wall_ms: min/median of the clean build_app.sh runs")
+    print("  • compile_units / compile_cpu_ms / ninja_span_ms: from build_profile.json")
+    print("  • image_size and used bytes per memory region: from size_report.json")
+    print("  • unity_vs_normal: relative wall time and absolute size differences")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 benchmarks/bench_unity_build.py gpio_test")
+    print("  python3 benchmarks/bench_unity_build.py adc_test --runs 3 --output unity.json")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Compare clean builds of the unity and the normal build type",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("app", nargs="?", help="App to build")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--normal", default=DEFAULT_NORMAL_TYPE, help="Normal build type")
+    parser.add_argument("--unity", default=DEFAULT_UNITY_TYPE, help="Unity build type")
+    parser.add_argument("--idf-version", default="", help="ESP-IDF version")
+    parser.add_argument("--runs", type=int, default=DEFAULT_RUNS, help="Clean builds per build type")
+    parser.add_argument("--project-path", help="Project directory")
+    parser.add_argument("--output", "-o", help="Output file path")
+
+    args = parser.parse_args()
+
+    if args.help or not args.app:
+        show_help()
+
+    return args
+
+def read_json(path):
+    """Load a JSON report, None when it is missing or unreadable."""
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return None
+
+def clean_build(project, app, build_type, idf_version):
+    """Run one clean build and collect its timing and size figures."""
+    argv = ["bash", str(SCRIPTS_DIR / "build_app.sh"), app, build_type]
+    if idf_version:
+        argv.append(idf_version)
+    argv += BUILD_OPTIONS
+    if project:
+        argv += ["--project-path", str(project)]
+
+    start = time.perf_counter()
+    proc = subprocess.run(argv, cwd=project or SCRIPTS_DIR.parent,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    wall_ms = (time.perf_counter() - start) * 1000
+
+    run = {'wall_ms': round(wall_ms, 1), 'exit_code': proc.returncode}
+    match = re.search(r"^ESP32_BUILD_APP_MOST_RECENT_DIRECTORY=(.*)$", proc.stdout, re.MULTILINE)
+    if proc.returncode != 0 or not match:
+        run['log_tail'] = proc.stdout.splitlines()[-20:]
+        return run
+
+    build_dir = Path(match.group(1))
+    profile = read_json(build_dir / "build_profile.json") or {}
+    compile_kind = profile.get('kinds', {}).get('compile', {})
+    run.update({
+        'build_dir': str(build_dir),
+        'compile_units': compile_kind.get('count'),
+        'compile_cpu_ms': compile_kind.get('cpu_ms'),
+        'project_cpu_ms': profile.get('origin_cpu_ms', {}).get('project'),
+        'ninja_span_ms': profile.get('ninja_span_ms'),
+    })
+    size = read_json(build_dir / "size_report.json") or {}
+    run['image_size'] = size.get('image_size')
+    run['memory_used'] = {region: info.get('used') for region, info in size.get('memory', {}).items()}
+    return run
+
+def summarize(build_type, runs):
+    """Reduce the runs of one build type to a single result entry."""
+    ok = [run for run in runs if run['exit_code'] == 0]
+    entry = {'build_type': build_type, 'runs': runs, 'failed_runs': len(runs) - len(ok)}
+    if ok:
+        walls = [run['wall_ms'] for run in ok]
+        last = ok[-1]
+        entry.update({
+            'wall_ms': {'min': min(walls), 'median': round(statistics.median(walls), 1)},
+            'compile_units': last.get('compile_units'),
+            'compile_cpu_ms': last.get('compile_cpu_ms'),
+            'project_cpu_ms': last.get('project_cpu_ms'),
+            'ninja_span_ms': last.get('ninja_span_ms'),
+            'image_size': last.get('image_size'),
+            'memory_used': last.get('memory_used', {}),
+        })
+    return entry
+
+def compare(normal, unity):
+    """Difference of the unity build against the normal build."""
+    if 'wall_ms' not in normal or 'wall_ms' not in unity:
+        return None
+
+    def delta(key):
+        if normal.get(key) is None or unity.get(key) is None:
+            return None
+        return unity[key] - normal[key]
+
+    normal_ms = normal['wall_ms']['median']
+    return {
+        'wall_ms_delta': round(unity['wall_ms']['median'] - normal_ms, 1),
+        'wall_ratio': round(unity['wall_ms']['median'] / normal_ms, 3) if normal_ms else None,
+        'compile_units_delta': delta('compile_units'),
+        'compile_cpu_ms_delta': delta('compile_cpu_ms'),
+        'image_size_delta': delta('image_size'),
+        'memory_used_delta': {
+            region: unity['memory_used'][region] - used
+            for region, used in normal.get('memory_used', {}).items()
+            if used is not None and unity.get('memory_used', {}).get(region) is not None
+        },
+    }
+
+def print_summary(app, normal, unity, comparison):
+    """Print a side-by-side table to stderr."""
+    def cell(entry, key):
+        if key == 'wall_ms':
+            return f"{entry['wall_ms']['median'] / 1000:.1f}s" if 'wall_ms' in entry else "failed"
+        value = entry.get(key)
+        return "-" if value is None else str(value)
+
+    rows = [("Clean build (median)", 'wall_ms'), ("Compile units", 'compile_units'),
+            ("Compile CPU ms", 'compile_cpu_ms'), ("Image size (bytes)", 'image_size')]
+    print(f"\n=== Unity build benchmark: {app} ===", file=sys.stderr)
+    print(f"{'':24}{normal['build_type']:>14}{unity['build_type']:>14}", file=sys.stderr)
+    for label, key in rows:
+        print(f"{label:24}{cell(normal, key):>14}{cell(unity, key):>14}", file=sys.stderr)
+    if comparison and comparison['wall_ratio'] is not None:
+        line = f"Unity build: {comparison['wall_ratio']:.2f}x the normal clean-build time"
+        if comparison['image_size_delta'] is not None:
+            line += f", image size {comparison['image_size_delta']:+d} bytes"
+        print(line, file=sys.stderr)
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    project = Path(args.project_path).resolve() if args.project_path else None
+    results = {
+        'format': RESULTS_FORMAT,
+        'timestamp': time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        'host': {
+            'platform': platform.platform(),
+            'python': platform.python_version(),
+            'cpus': os.cpu_count(),
+        },
+        'app': args.app,
+        'idf_version': args.idf_version or None,
+        'build_options': BUILD_OPTIONS,
+    }
+
+    entries = {}
+    for build_type in (args.normal, args.unity):
+        runs = []
+        for i in range(args.runs):
+            print(f"Clean build {i + 1}/{args.runs}: {args.app} {build_type}...", file=sys.stderr)
+            runs.append(clean_build(project, args.app, build_type, args.idf_version))
+        entries[build_type] = summarize(build_type, runs)
+
+    normal, unity = entries[args.normal], entries[args.unity]
+    results['normal'] = normal
+    results['unity'] = unity
+    results['unity_vs_normal'] = compare(normal, unity)
+    print_summary(args.app, normal, unity, results['unity_vs_normal'])
+
+    output = json.dumps(results, indent=2)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(output + "\n")
+        print(f"Results written to {args.output}", file=sys.stderr)
+    else:
+        print(output)
+
+    if normal['failed_runs'] or unity['failed_runs']:
+        print("Some builds failed, see log_tail in the results", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -7,11 +7,25 @@
 
 set -e  # Exit on any error
 
+# Phase timings for build_profile.py (name<TAB>start<TAB>end in epoch seconds)
+BUILD_PHASES=()
+PHASE_BEGIN=$EPOCHREALTIME
+phase_begin() {
+    PHASE_BEGIN=$EPOCHREALTIME
+}
+phase_end() {
+    BUILD_PHASES+=("$1"$'\t'"$PHASE_BEGIN"$'\t'"$EPOCHREALTIME")
+}
+
 # Parse arguments: collect non-flag args as positionals
+# (ORIGINAL_ARGS restarts watch mode with the same command line when the configuration changes)
+ORIGINAL_ARGS=("$@")
 POSITIONAL_ARGS=()
 i=1
 while [[ $i -le $# ]]; do
 	arg="${!i}"
+	next_i=$((i+1))
+	next_arg="${!next_i}"
 	case "$arg" in
 		--clean)
 			CLEAN=1
@@ -25,10 +39,55 @@ while [[ $i -le $# ]]; do
 		--no-cache)
 			USE_CCACHE=0
 			;;
+		--reconfigure)
+			FORCE_RECONFIGURE=1
+			;;
+		--no-artifact-cache)
+			USE_ARTIFACT_CACHE=0
+			;;
+		--shared-build)
+			SHARED_BUILD=1
+			;;
+		--no-clone)
+			CLONE_BUILD_TREE=0
+			;;
+		--watch)
+			WATCH=1
+			;;
+		--profile-compile)
+			PROFILE_COMPILE=1
+			;;
+		--no-shared-build)
+			SHARED_BUILD=0
+			;;
+		--ram-build)
+			RAM_BUILD=1
+			;;
+		--no-ram-build)
+			RAM_BUILD=0
+			;;
+		--all)
+			BUILD_ALL=1
+			;;
+		--matrix|--parallel)
+			# Both options take a value
+			if [[ $next_i -le $# ]] && [[ "$next_arg" != -* ]]; then
+				if [[ "$arg" == "--matrix" ]]; then
+					MATRIX_FILE="$next_arg"
+				else
+					MATRIX_PARALLEL="$next_arg"
+				fi
+				((i++))  # Skip the next argument since we consumed it
+			else
+				echo "ERROR: $arg requires an argument" >&2
+				echo "Usage: --matrix matrix.json | --parallel <builds>" >&2
+				exit 1
+			fi
+			;;
 		--project-path)
 			# Check if next argument exists and is not another flag
-			if [[ $((i+1)) -le $# ]] && [[ "${!((i+1))}" != -* ]]; then
-				PROJECT_PATH="${!((i+1))}"
+			if [[ $next_i -le $# ]] && [[ "$next_arg" != -* ]]; then
+				PROJECT_PATH="$next_arg"
 				((i++))  # Skip the next argument since we consumed it
 			else
 				echo "ERROR: --project-path requires a path argument" >&2
@@ -51,15 +110,15 @@ if [[ -n "$PROJECT_PATH" ]]; then
     export PROJECT_PATH
 fi
 
-# Configuration derived from positionals or config defaults
-APP_TYPE=${POSITIONAL_ARGS[0]:-$CONFIG_DEFAULT_APP}
-BUILD_TYPE=${POSITIONAL_ARGS[1]:-$CONFIG_DEFAULT_BUILD_TYPE}
-
 # Load configuration
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_DIR="$(cd "$SCRIPT_DIR/.." && pwd)"
 source "$SCRIPT_DIR/config_loader.sh"
 
+# Configuration derived from positionals or config defaults
+APP_TYPE=${POSITIONAL_ARGS[0]:-$CONFIG_DEFAULT_APP}
+BUILD_TYPE=${POSITIONAL_ARGS[1]:-$CONFIG_DEFAULT_BUILD_TYPE}
+
 # Usage helper
 print_usage() {
     echo "ESP32 HardFOC Interface Wrapper - Build System"
@@ -72,13 +131,25 @@ print_usage() {
     echo "  info <app_name>                         - Show detailed information for specific app"
     echo "  combinations                            - Show all valid build combinations"
     echo "  validate <app> <type> [idf]            - Validate specific build combination"
+    echo "  --all                                  - Build every CI matrix entry concurrently"
+    echo "  --matrix <file>                        - Build the entries of a matrix file concurrently"
     echo ""
     echo "OPTIONS:"
     echo "  --clean                                - Clean build (remove existing build directory)"
     echo "  --no-clean                             - Incremental build (preserve existing build directory)"
-    echo "  --use-cache                            - Enable ccache for faster builds (default)"
+    echo "  --use-cache                            - Enable ccache for faster builds (default when installed)"
     echo "  --no-cache                             - Disable ccache"
+    echo "  --reconfigure                          - Always run CMake configure (ignore the build fingerprint)"
+    echo "  --no-artifact-cache                    - Neither restore from nor store into the artifact cache"
+    echo "  --shared-build                         - One tree per target/IDF/build type, reconfigured per app (opt-in)"
+    echo "  --no-shared-build                      - Build in the app's own tree (overrides shared_component_build)"
+    echo "  --no-clone                             - Configure new build directories cold (no sibling template)"
+    echo "  --ram-build                            - Compile in a tmpfs tree, sync only the artifacts back"
+    echo "  --no-ram-build                         - Compile in the build directory (overrides ram_build)"
+    echo "  --watch                                - Stay running: rebuild incrementally whenever app sources change"
+    echo "  --profile-compile                      - Attribute front-end time to headers (compile_profile.txt)"
     echo "  --project-path <path>                  - Path to project directory (allows scripts to be placed anywhere)"
+    echo "  --parallel <n>                         - Concurrent builds for --all/--matrix (overrides parallel_builds)"
     echo "  -h, --help                             - Show this help message"
     echo ""
     echo "ARGUMENT PATTERNS:"
@@ -94,6 +165,22 @@ print_usage() {
     echo "      - Example: PROJECT_PATH=/path/to/project ./build_app.sh"
     echo "    CLEAN        - Set to 1 for clean builds, 0 for incremental"
     echo "    USE_CCACHE   - Set to 1 to enable ccache, 0 to disable"
+    echo "    BUILD_JOBS   - Ninja job count for the build step (set per build by --all/--matrix)"
+    echo "    FORCE_RECONFIGURE - Set to 1 to always run CMake configure"
+    echo "    USE_ARTIFACT_CACHE - Set to 0 to bypass the firmware artifact cache"
+    echo "    IDF_SERVER - Set to 1 to run idf.py through the persistent idf_server.py"
+    echo "    SHARED_BUILD - Set to 1 for the shared component build (as --shared-build)"
+    echo "    CLONE_BUILD_TREE - Set to 0 to configure new build directories cold (as --no-clone)"
+    echo "    RAM_BUILD / RAM_BUILD_PATH - RAM-backed build trees (as --ram-build) and their location (/dev/shm)"
+    echo "    WATCH_FLASH_PORT - With --watch, flash the app partition to this port after each rebuild"
+    echo "    DIFF_FLASH - With WATCH_FLASH_PORT, write only the changed sectors (flash_diff.py)"
+    echo "    ESP32_ARTIFACT_CACHE_DIR / ESP32_ARTIFACT_CACHE_SIZE - Artifact cache location and budget"
+    echo ""
+    echo "  Parallel Builds (--all / --matrix):"
+    echo "    - Entries come from 'generate_matrix.py' (--all) or a matrix file ({\"include\": [...]})"
+    echo "    - Concurrency is bounded by build_config.parallel_builds, cpu_limit and memory_limit"
+    echo "    - The cpu_limit ninja jobs are divided across the concurrent builds"
+    echo "    - Per-build logs and build_summary.json are written to logs/builds/<timestamp>/"
     echo ""
     echo "EXAMPLES:"
     echo "  # Basic usage with defaults"
@@ -106,6 +193,11 @@ print_usage() {
     echo "  ./build_app.sh adc_test Debug --no-cache          # Without cache"
     echo "  ./build_app.sh gpio_test Release --no-clean       # Incremental build"
     echo ""
+    echo "  # Parallel builds"
+    echo "  ./build_app.sh --all                              # Every CI matrix entry"
+    echo "  ./build_app.sh --all --parallel 2 --clean         # Two clean builds at a time"
+    echo "  ./build_app.sh --matrix matrix.json               # Entries from generate_matrix.py --output"
+    echo ""
     echo "  # Information commands"
     echo "  ./build_app.sh list                               # List all apps and types"
     echo "  ./build_app.sh info gpio_test                     # App-specific details"
@@ -190,26 +282,318 @@ if [ "$HELP_REQUESTED" = "1" ]; then
     exit 0
 fi
 
+# Rough peak memory of one ESP-IDF build (compile jobs + linker), checked against memory_limit
+MATRIX_MEMORY_PER_BUILD_MB=${MATRIX_MEMORY_PER_BUILD_MB:-2048}
+# Ninja jobs per build when parallel_builds is true (automatic concurrency)
+MATRIX_AUTO_JOBS_PER_BUILD=4
+
+# Convert a memory size (16G, 512M, 2048 = megabytes) to megabytes
+memory_to_mb() {
+    local value="${1^^}"
+    value="${value%B}"
+    if ! [[ "$value" =~ ^[0-9]+[KMGT]?$ ]]; then
+        return 1
+    fi
+    case "$value" in
+        *T) echo $(( ${value%T} * 1024 * 1024 )) ;;
+        *G) echo $(( ${value%G} * 1024 )) ;;
+        *M) echo "${value%M}" ;;
+        *K) echo $(( ${value%K} / 1024 )) ;;
+        *)  echo "$value" ;;
+    esac
+}
+
+# Work out MATRIX_CONCURRENCY (builds at a time) and MATRIX_JOBS (ninja jobs per build)
+# from build_config.parallel_builds, cpu_limit and memory_limit
+compute_matrix_concurrency() {
+    local entry_count="$1"
+    local cpus
+    cpus=$(nproc 2>/dev/null || getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+
+    local cpu_limit
+    cpu_limit=$(get_build_config_value cpu_limit "$cpus")
+    if ! [[ "$cpu_limit" =~ ^[0-9]+$ ]] || [ "$cpu_limit" -lt 1 ]; then
+        echo "WARNING: Ignoring invalid build_config.cpu_limit: $cpu_limit"
+        cpu_limit=$cpus
+    elif [ "$cpu_limit" -gt "$cpus" ]; then
+        cpu_limit=$cpus
+    fi
+
+    local parallel="$MATRIX_PARALLEL"
+    if [ -z "$parallel" ]; then
+        parallel=$(get_build_config_value parallel_builds true)
+    fi
+    case "$parallel" in
+        true|auto)
+            MATRIX_CONCURRENCY=$(( cpu_limit / MATRIX_AUTO_JOBS_PER_BUILD ))
+            ;;
+        false)
+            MATRIX_CONCURRENCY=1
+            ;;
+        *)
+            if [[ "$parallel" =~ ^[0-9]+$ ]] && [ "$parallel" -gt 0 ]; then
+                MATRIX_CONCURRENCY=$parallel
+            else
+                echo "WARNING: Ignoring invalid parallel_builds value: $parallel"
+                MATRIX_CONCURRENCY=1
+            fi
+            ;;
+    esac
+
+    local memory_limit memory_mb
+    memory_limit=$(get_build_config_value memory_limit "")
+    if [ -n "$memory_limit" ]; then
+        if memory_mb=$(memory_to_mb "$memory_limit"); then
+            local by_memory=$(( memory_mb / MATRIX_MEMORY_PER_BUILD_MB ))
+            if [ "$MATRIX_CONCURRENCY" -gt "$by_memory" ]; then
+                MATRIX_CONCURRENCY=$by_memory
+            fi
+        else
+            echo "WARNING: Ignoring invalid build_config.memory_limit: $memory_limit"
+        fi
+    fi
+
+    if [ "$MATRIX_CONCURRENCY" -gt "$cpu_limit" ]; then
+        MATRIX_CONCURRENCY=$cpu_limit
+    fi
+    if [ "$MATRIX_CONCURRENCY" -gt "$entry_count" ]; then
+        MATRIX_CONCURRENCY=$entry_count
+    fi
+    if [ "$MATRIX_CONCURRENCY" -lt 1 ]; then
+        MATRIX_CONCURRENCY=1
+    fi
+
+    # Divide the CPU budget between the concurrent builds
+    MATRIX_JOBS=$(( cpu_limit / MATRIX_CONCURRENCY ))
+    if [ "$MATRIX_JOBS" -lt 1 ]; then
+        MATRIX_JOBS=1
+    fi
+}
+
+# Build every matrix entry with a bounded number of concurrent build_app.sh runs
+run_build_matrix() {
+    local matrix_args=(--project-path "$PROJECT_DIR" --format tsv)
+    if [ -n "$MATRIX_FILE" ]; then
+        matrix_args+=(--input "$MATRIX_FILE")
+    fi
+
+    local matrix_tsv
+    if ! matrix_tsv=$(python3 "$SCRIPT_DIR/generate_matrix.py" "${matrix_args[@]}"); then
+        echo "ERROR: Could not load the build matrix"
+        return 1
+    fi
+
+    local entries=()
+    if [ -n "$matrix_tsv" ]; then
+        mapfile -t entries <<< "$matrix_tsv"
+    fi
+    local total=${#entries[@]}
+    if [ "$total" -eq 0 ]; then
+        echo "ERROR: The build matrix is empty"
+        return 1
+    fi
+
+    compute_matrix_concurrency "$total"
+
+    local run_id
+    run_id=$(date +%Y%m%d_%H%M%S)
+    local log_dir="$PROJECT_DIR/logs/builds/$run_id"
+    local status_dir="$log_dir/.status"
+    mkdir -p "$status_dir"
+
+    # Builds for another ESP-IDF version than the active one must export their own environment
+    local active_idf="$IDF_VERSION"
+
+    # Shared component trees are cleaned once here, not by every build that uses them
+    if [ "$SHARED_BUILD" = "1" ] && [ "$CLEAN" = "1" ]; then
+        rm -rf "$PROJECT_DIR"/build-shared-*
+        if [ "$RAM_BUILD" = "1" ]; then
+            rm -rf "$RAM_BUILD_ROOT"/build-shared-*
+        fi
+    fi
+
+    echo "=== ESP32 Parallel Build ==="
+    echo "Builds: $total"
+    echo "Concurrent builds: $MATRIX_CONCURRENCY"
+    echo "Ninja jobs per build: $MATRIX_JOBS"
+    echo "Log directory: $log_dir"
+    echo "======================================================="
+
+    local -a entry_log=() entry_dir=() entry_rc=() entry_start=() entry_end=()
+    local -A running=()
+    local next=0 finished=0 failed=0
+    local started_at
+    started_at=$(date +%s)
+
+    while [ "$next" -lt "$total" ] || [ "${#running[@]}" -gt 0 ]; do
+        # Fill free slots
+        while [ "$next" -lt "$total" ] && [ "${#running[@]}" -lt "$MATRIX_CONCURRENCY" ]; do
+            local app build_type idf_version target
+            IFS=$'\t' read -r app build_type idf_version target <<< "${entries[$next]}"
+
+            local env_unset=()
+            if [ -n "$active_idf" ] && [ "$active_idf" != "$idf_version" ]; then
+                env_unset=(-u IDF_PATH)
+            fi
+
+            entry_log[$next]="$log_dir/${app}_${build_type}_${idf_version//[\/.]/_}.log"
+            config_expand_build_directory "entry_dir[$next]" "$app" "$build_type" "$target" "$idf_version"
+            entry_start[$next]=$(date +%s)
+            echo "[start] $app $build_type $idf_version ($target)"
+
+            (
+                env "${env_unset[@]}" BUILD_JOBS="$MATRIX_JOBS" CLEAN="$CLEAN" USE_CCACHE="$USE_CCACHE" \
+                    SHARED_BUILD="$SHARED_BUILD" SHARED_BUILD_CLEAN=0 \
+                    RAM_BUILD="$RAM_BUILD" RAM_BUILD_PATH="$RAM_BUILD_PATH" \
+                    "$SCRIPT_DIR/build_app.sh" "$app" "$build_type" "$idf_version" \
+                    > "${entry_log[$next]}" 2>&1 < /dev/null && rc=0 || rc=$?
+                write_job_status "$status_dir/$next" "$rc" "$(date +%s)"
+            ) &
+            running[$!]=$next
+            next=$(( next + 1 ))
+        done
+
+        wait -n 2>/dev/null || true
+
+        # Collect finished builds
+        local pid index
+        for pid in "${!running[@]}"; do
+            index=${running[$pid]}
+            if [ -f "$status_dir/$index" ] || ! kill -0 "$pid" 2>/dev/null; then
+                local rc=255 end
+                end=$(date +%s)
+                if [ -f "$status_dir/$index" ]; then
+                    read -r rc end < "$status_dir/$index"
+                fi
+                unset "running[$pid]"
+                entry_rc[$index]=$rc
+                entry_end[$index]=$end
+                finished=$(( finished + 1 ))
+
+                local app build_type idf_version target
+                IFS=$'\t' read -r app build_type idf_version target <<< "${entries[$index]}"
+                local duration=$(( end - entry_start[index] ))
+                if [ "$rc" -eq 0 ]; then
+                    echo "[$finished/$total] ✅ $app $build_type $idf_version (${duration}s)"
+                else
+                    failed=$(( failed + 1 ))
+                    echo "[$finished/$total] ❌ $app $build_type $idf_version (exit $rc, ${duration}s) - see ${entry_log[$index]}"
+                fi
+            fi
+        done
+    done
+    rm -rf "$status_dir"
+
+    local finished_at
+    finished_at=$(date +%s)
+    local summary_file="$log_dir/build_summary.json"
+    {
+        echo "{"
+        echo "  \"started\": $(json_string "$(iso_time "$started_at")"),"
+        echo "  \"duration_s\": $(( finished_at - started_at )),"
+        echo "  \"concurrency\": $MATRIX_CONCURRENCY,"
+        echo "  \"jobs_per_build\": $MATRIX_JOBS,"
+        echo "  \"total\": $total,"
+        echo "  \"succeeded\": $(( total - failed )),"
+        echo "  \"failed\": $failed,"
+        echo "  \"builds\": ["
+        local index separator=","
+        for index in "${!entries[@]}"; do
+            local app build_type idf_version target
+            IFS=$'\t' read -r app build_type idf_version target <<< "${entries[$index]}"
+            if [ "$index" -eq $(( total - 1 )) ]; then
+                separator=""
+            fi
+            echo "    {\"app_name\": $(json_string "$app"), \"build_type\": $(json_string "$build_type")," \
+                 "\"idf_version\": $(json_string "$idf_version"), \"target\": $(json_string "$target")," \
+                 "\"status\": \"$([ "${entry_rc[$index]}" -eq 0 ] && echo success || echo failed)\"," \
+                 "\"exit_code\": ${entry_rc[$index]}, \"duration_s\": $(( entry_end[index] - entry_start[index] ))," \
+                 "\"build_dir\": $(json_string "${entry_dir[$index]}"), \"log\": $(json_string "${entry_log[$index]}")}$separator"
+        done
+        echo "  ]"
+        echo "}"
+    } > "$summary_file"
+
+    echo "======================================================="
+    echo "Parallel build finished in $(( finished_at - started_at ))s: $(( total - failed ))/$total succeeded"
+    echo "Summary: $summary_file"
+    if [ "$failed" -gt 0 ]; then
+        return 1
+    fi
+    return 0
+}
+
+# Shared component build: --shared-build/SHARED_BUILD, else build_config.shared_component_build
+if [ -z "$SHARED_BUILD" ]; then
+    case "$(get_build_config_value shared_component_build false)" in
+        true|1) SHARED_BUILD=1 ;;
+        *) SHARED_BUILD=0 ;;
+    esac
+fi
+
+# RAM-backed build trees: --ram-build/RAM_BUILD, else build_config.ram_build. Object files live
+# below RAM_BUILD_PATH (build_config.ram_build_path, default /dev/shm), one directory per checkout.
+if [ -z "$RAM_BUILD" ]; then
+    case "$(get_build_config_value ram_build false)" in
+        true|1) RAM_BUILD=1 ;;
+        *) RAM_BUILD=0 ;;
+    esac
+fi
+if [ "$RAM_BUILD" = "1" ]; then
+    RAM_BUILD_PATH="${RAM_BUILD_PATH:-$(get_build_config_value ram_build_path /dev/shm)}"
+    RAM_BUILD_ROOT="$RAM_BUILD_PATH/esp32-build-$(id -u)/$(printf '%s' "$PROJECT_DIR" | sha256sum | cut -c1-12)"
+    if ! mkdir -p "$RAM_BUILD_ROOT" 2>/dev/null || [ ! -w "$RAM_BUILD_ROOT" ]; then
+        echo "WARNING: RAM build path $RAM_BUILD_PATH is not writable, building on disk"
+        RAM_BUILD=0
+    fi
+fi
+
+# Watch mode rebuilds one app in place: its own tree, nothing restored from or stored in the cache
+if [ "$WATCH" = "1" ]; then
+    if [ "$BUILD_ALL" = "1" ] || [ -n "$MATRIX_FILE" ]; then
+        echo "ERROR: --watch builds a single app and cannot be combined with --all/--matrix" >&2
+        exit 1
+    fi
+    SHARED_BUILD=0
+    USE_ARTIFACT_CACHE=0
+fi
+
+# Compile profiling re-parses the app's units from its own configured tree after the build
+if [ "$PROFILE_COMPILE" = "1" ]; then
+    if [ "$BUILD_ALL" = "1" ] || [ -n "$MATRIX_FILE" ]; then
+        echo "ERROR: --profile-compile profiles a single app and cannot be combined with --all/--matrix" >&2
+        exit 1
+    fi
+    SHARED_BUILD=0
+    USE_ARTIFACT_CACHE=0
+fi
+
+# Parallel multi-build mode (before the single-build commands and validation)
+if [ "$BUILD_ALL" = "1" ] || [ -n "$MATRIX_FILE" ]; then
+    if [ ${#POSITIONAL_ARGS[@]} -gt 0 ]; then
+        echo "WARNING: Ignoring positional arguments in --all/--matrix mode: ${POSITIONAL_ARGS[*]}"
+    fi
+    if run_build_matrix; then
+        exit 0
+    fi
+    exit 1
+fi
+
 # Handle special commands first (before validation)
 # Handle special commands
 if [ "$APP_TYPE" = "list" ]; then
     echo "=== Available App Types ==="
+    eval "$(config_query featured_app_types app_types build_types idf_versions)"
     echo "Featured apps:"
-    for app in $(get_featured_app_types); do
-        description=$(get_app_description "$app")
-        echo "  $app - $description"
-    done
+    print_app_descriptions $FEATURED_APP_TYPES
     echo ""
     echo "All apps:"
-    for app in $(get_app_types); do
-        description=$(get_app_description "$app")
-        echo "  $app - $description"
-    done
+    print_app_descriptions $APP_TYPES
     echo ""
-    echo "Build types: $(get_build_types)"
-    echo "ESP-IDF versions: $(get_idf_versions)"
+    echo "Build types: $BUILD_TYPES"
+    echo "ESP-IDF versions: $IDF_VERSIONS"
     echo ""
-    echo "Flags: --clean | --no-clean | --use-cache | --no-cache"
+    echo "Flags: --clean | --no-clean | --use-cache | --no-cache | --reconfigure"
     echo ""
     echo "Additional Commands:"
     echo "  info <app_name>        - Show detailed information for specific app"
@@ -240,7 +624,12 @@ fi
 if [ "$APP_TYPE" = "validate" ] && [ -n "${POSITIONAL_ARGS[1]}" ] && [ -n "${POSITIONAL_ARGS[2]}" ]; then
     app_name="${POSITIONAL_ARGS[1]}"
     build_type="${POSITIONAL_ARGS[2]}"
-    idf_version="${POSITIONAL_ARGS[3]:-$(get_idf_version_for_build_type "$app_name" "$build_type")}"
+    idf_version="${POSITIONAL_ARGS[3]}"
+    VALID_COMBINATION=false
+    if is_valid_app_type "$app_name"; then
+        eval "$(config_query --app "$app_name" --build-type "$build_type" --idf-version "$idf_version" idf_version valid_combination)"
+        idf_version="$IDF_VERSION"
+    fi
     
     echo "=== Validating Build Combination ==="
     echo "App: $app_name"
@@ -248,7 +637,7 @@ if [ "$APP_TYPE" = "validate" ] && [ -n "${POSITIONAL_ARGS[1]}" ] && [ -n "${POS
     echo "ESP-IDF Version: $idf_version"
     echo ""
     
-    if is_valid_combination "$app_name" "$build_type" "$idf_version"; then
+    if [ "$VALID_COMBINATION" = "true" ]; then
         echo "✅ VALID: This combination is allowed!"
     else
         echo "❌ INVALID: This combination is not allowed!"
@@ -275,18 +664,35 @@ if ! is_valid_build_type "$BUILD_TYPE"; then
     exit 1
 fi
 
-# Smart IDF version selection (only after basic validation passes)
-if [ -n "${POSITIONAL_ARGS[2]}" ]; then
-    IDF_VERSION="${POSITIONAL_ARGS[2]}"
-else
-    # Use smart default based on app and build type
-    source "$SCRIPT_DIR/config_loader.sh"
-    IDF_VERSION=$(get_idf_version_for_build_type "$APP_TYPE" "$BUILD_TYPE")
+# Target from config: the app's own target override, else metadata.target (as in the build matrix)
+export IDF_TARGET=$(get_target "$APP_TYPE")
+echo "Target set from config: $IDF_TARGET"
+
+# Resolve everything the build needs from the configuration in one query:
+# IDF_VERSION (smart default when not given), DESCRIPTION, BUILD_DIR, PROJECT_NAME, SOURCE_FILE
+eval "$(config_query --app "$APP_TYPE" --build-type "$BUILD_TYPE" --idf-version "${POSITIONAL_ARGS[2]}" \
+    --target "$IDF_TARGET" idf_version description build_dir project_name source_file)"
+phase_end config
+if [ -z "${POSITIONAL_ARGS[2]}" ]; then
     echo "No IDF version specified, using smart default for $BUILD_TYPE: $IDF_VERSION"
 fi
 
+# Build type settings (build_config.build_types.<type>): the CMake build type it maps to, so a
+# "Unity" type can build as Release, and the unity (jumbo) build of the app and wrapper sources
+CMAKE_BUILD_TYPE_NAME=$(get_build_type_config_value "$BUILD_TYPE" cmake_build_type "$BUILD_TYPE")
+case "$(get_build_type_config_value "$BUILD_TYPE" unity_build false)" in
+    true|1) UNITY_BUILD=ON ;;
+    *) UNITY_BUILD=OFF ;;
+esac
+UNITY_BUILD_BATCH_SIZE=$(get_build_type_config_value "$BUILD_TYPE" unity_batch_size 8)
+case "$(get_build_type_config_value "$BUILD_TYPE" precompiled_headers false)" in
+    true|1) PCH_BUILD=1 ;;
+    *) PCH_BUILD=0 ;;
+esac
+
 # Ensure ESP-IDF environment is sourced for the specified version
 if [ -z "$IDF_PATH" ] || ! command -v idf.py &> /dev/null; then
+    phase_begin
     echo "ESP-IDF environment not found, attempting to auto-setup version $IDF_VERSION..."
     
     # Source the common setup functions to use export_esp_idf_version
@@ -304,26 +710,34 @@ if [ -z "$IDF_PATH" ] || ! command -v idf.py &> /dev/null; then
         echo "To manually install required versions, run: ./scripts/setup_repo.sh"
         exit 1
     fi
+    phase_end idf_export
 fi
 
-# Ensure target is set from config
-if [[ -z "$CONFIG_TARGET" ]]; then
-    # Source config_loader to get target from app_config.yml
-    source "$SCRIPT_DIR/config_loader.sh"
-    export IDF_TARGET=$(get_target)
-    echo "Target set from config: $IDF_TARGET"
-else
-    export IDF_TARGET="$CONFIG_TARGET"
-    echo "Target set from environment: $IDF_TARGET"
+# ccache is on by default when available (ESP-IDF ships it with its tools)
+if [ -z "$USE_CCACHE" ]; then
+    if command -v ccache &> /dev/null; then
+        USE_CCACHE=1
+    else
+        USE_CCACHE=0
+    fi
 fi
 
 echo "=== ESP32 HardFOC Interface Wrapper Build System ==="
 echo "Project Directory: $PROJECT_DIR"
 echo "App Type: $APP_TYPE"
 echo "Build Type: $BUILD_TYPE"
+if [ "$CMAKE_BUILD_TYPE_NAME" != "$BUILD_TYPE" ]; then
+    echo "CMake Build Type: $CMAKE_BUILD_TYPE_NAME"
+fi
+if [ "$UNITY_BUILD" = "ON" ]; then
+    echo "Unity Build: ON (batch size $UNITY_BUILD_BATCH_SIZE)"
+fi
+if [ "$PCH_BUILD" = "1" ]; then
+    echo "Precompiled Headers: ON"
+fi
 echo "ESP-IDF Version: $IDF_VERSION"  # NEW: Show ESP-IDF version
-echo "Target: $CONFIG_TARGET"
-echo "Build Directory: $(get_build_directory "$APP_TYPE" "$BUILD_TYPE")"
+echo "Target: $IDF_TARGET"
+echo "Build Directory: $BUILD_DIR"
 echo "======================================================="
 
 # Enhanced validation with combination checking
@@ -360,15 +774,13 @@ validate_build_combination() {
 
 # Basic validations moved above - show app info here
 echo "Valid app type: $APP_TYPE"
-description=$(get_app_description "$APP_TYPE")
-echo "Description: $description"
+echo "Description: $DESCRIPTION"
 echo "Valid build type: $BUILD_TYPE"
 
 # Validate the complete combination
 validate_build_combination "$APP_TYPE" "$BUILD_TYPE" "$IDF_VERSION"
 
-# Set build directory using configuration (includes target and IDF version)
-BUILD_DIR=$(get_build_directory "$APP_TYPE" "$BUILD_TYPE" "$IDF_TARGET" "$IDF_VERSION")
+# Build directory from configuration (includes target and IDF version)
 echo "Build directory: $BUILD_DIR"
 
 # Clean previous build only if explicitly requested
@@ -381,22 +793,587 @@ else
     fi
 fi
 
+# Shared component build: one tree per (IDF version, target, build type, sdkconfig) that every
+# app is built in, in turn. APP_TYPE is a configure input, so switching apps reconfigures the
+# tree; ninja then reruns every edge whose command changed, which is only the app's own sources
+# and the link as long as APP_TYPE does not reach other components' compile definitions. The
+# outputs are copied into the app's build directory. BUILD_TREE is where CMake and ninja run.
+BUILD_TREE="$BUILD_DIR"
+if [ "$SHARED_BUILD" = "1" ]; then
+    SDKCONFIG_KEY=$(cat "$PROJECT_DIR"/sdkconfig.defaults* 2>/dev/null | sha256sum | cut -c1-12)
+    BUILD_TREE="$PROJECT_DIR/build-shared-type-$BUILD_TYPE-target-$IDF_TARGET-idf-${IDF_VERSION//[\/.]/_}-$SDKCONFIG_KEY"
+fi
+
+# RAM build: the same tree (own or shared) under RAM_BUILD_ROOT; the build directory only
+# receives the final artifacts
+if [ "$RAM_BUILD" = "1" ]; then
+    BUILD_TREE="$RAM_BUILD_ROOT/$(basename "$BUILD_TREE")"
+    if [ "$CLEAN" = "1" ] && [ "$SHARED_BUILD" != "1" ]; then
+        rm -rf "$BUILD_TREE"
+    fi
+    mkdir -p "$BUILD_TREE" "$BUILD_DIR"
+    echo "RAM build tree: $BUILD_TREE"
+    RAM_FREE_KB=$(df -Pk "$BUILD_TREE" 2>/dev/null | awk 'NR == 2 { print $4 }')
+    if [ -n "$RAM_FREE_KB" ] && [ "$RAM_FREE_KB" -lt 1048576 ]; then
+        echo "WARNING: Only $(( RAM_FREE_KB / 1024 )) MB free in $RAM_BUILD_PATH"
+    fi
+fi
+
+if [ "$SHARED_BUILD" = "1" ]; then
+    mkdir -p "$BUILD_TREE" "$BUILD_DIR"
+    echo "Shared component build tree: $BUILD_TREE"
+
+    # One app at a time per shared tree (builds using other trees keep running in parallel)
+    if command -v flock &> /dev/null; then
+        exec {SHARED_LOCK_FD}> "$BUILD_TREE/.lock"
+        if ! flock -n "$SHARED_LOCK_FD"; then
+            echo "Waiting for another build using the shared tree..."
+            flock "$SHARED_LOCK_FD"
+        fi
+    fi
+    if [ "${SHARED_BUILD_CLEAN:-$CLEAN}" = "1" ]; then
+        echo "CLEAN=1 set: clearing the shared component build tree..."
+        find "$BUILD_TREE" -mindepth 1 -maxdepth 1 ! -name .lock -exec rm -rf {} +
+    fi
+fi
+
+# Copy an app's outputs from the shared or RAM build tree into its own build directory.
+# A CMake tree left there by an earlier in-place build is dropped: flash_app.sh would rebuild it.
+copy_build_tree_outputs() {
+    local name
+    rm -f "$BUILD_DIR/build.ninja" "$BUILD_DIR/CMakeCache.txt"
+    {
+        printf '%s\n' "$PROJECT_NAME.bin" "$PROJECT_NAME.elf" "$PROJECT_NAME.map" \
+            flasher_args.json flash_args flash_app_args flash_bootloader_args flash_project_args \
+            project_description.json .ninja_log bootloader/bootloader.elf bootloader/bootloader.map
+        # Every image flash_args refers to (bootloader, partition table, OTA data, data partitions)
+        if [ -f "$BUILD_TREE/flash_args" ]; then
+            awk 'NR > 1 { print $2 }' "$BUILD_TREE/flash_args"
+        fi
+    } | sort -u | while read -r name; do
+        if [ -f "$BUILD_TREE/$name" ]; then
+            mkdir -p "$BUILD_DIR/$(dirname "$name")"
+            cp -p "$BUILD_TREE/$name" "$BUILD_DIR/$name"
+        fi
+    done
+}
+
+# Everything that requires a CMake reconfigure when it changes, one input per line.
+# Stored as $BUILD_TREE/.build_fingerprint after a successful configure.
+BUILD_FINGERPRINT_FORMAT=2
+
+# Name of the target's GCC
+toolchain_compiler() {
+    case "$IDF_TARGET" in
+        esp32|esp32s2|esp32s3) echo "xtensa-$IDF_TARGET-elf-gcc" ;;
+        *) echo "riscv32-esp-elf-gcc" ;;
+    esac
+}
+
+# Toolchain version from the ESP-IDF tools layout (tools/<name>/<version>/...), else GCC's
+toolchain_version() {
+    local compiler
+    if ! compiler=$(command -v "$(toolchain_compiler)"); then
+        echo "unknown"
+        return
+    fi
+    compiler=$(readlink -f "$compiler" 2>/dev/null || echo "$compiler")
+    if [[ "$compiler" =~ /tools/[^/]+/([^/]+)/ ]]; then
+        echo "${BASH_REMATCH[1]}"
+    else
+        "$compiler" -dumpfullversion 2>/dev/null || echo "unknown"
+    fi
+}
+
+compute_build_fingerprint() {
+    local idf_commit="unknown"
+    if [ -n "$IDF_PATH" ]; then
+        idf_commit=$(git -C "$IDF_PATH" rev-parse HEAD 2>/dev/null || echo "unknown")
+    fi
+
+    local toolchain
+    toolchain=$(command -v "$(toolchain_compiler)" || echo "none")
+
+    # sdkconfig inputs, component manifests and the app configuration (content hashes)
+    local inputs=() file
+    for file in "$PROJECT_DIR"/sdkconfig "$PROJECT_DIR"/sdkconfig.defaults* \
+                "$PROJECT_DIR"/idf_component.yml "$PROJECT_DIR"/dependencies.lock \
+                "$PROJECT_DIR"/main/idf_component.yml "$PROJECT_DIR"/components/*/idf_component.yml \
+                "$CONFIG_FILE"; do
+        if [ -f "$file" ]; then
+            inputs+=("$file")
+        fi
+    done
+    local hashes=""
+    if [ ${#inputs[@]} -gt 0 ]; then
+        hashes=$(sha256sum "${inputs[@]}")
+    fi
+
+    printf '%s\n' \
+        "FORMAT=$BUILD_FINGERPRINT_FORMAT" \
+        "APP_TYPE=$APP_TYPE" \
+        "BUILD_TYPE=$BUILD_TYPE" \
+        "IDF_CCACHE_ENABLE=$USE_CCACHE" \
+        "IDF_TARGET=$IDF_TARGET" \
+        "IDF_VERSION=$IDF_VERSION" \
+        "IDF_PATH=$IDF_PATH" \
+        "IDF_COMMIT=$idf_commit" \
+        "TOOLCHAIN=$toolchain" \
+        "$hashes"
+    if [ -n "$PCH_DIR" ]; then
+        # CMake gives a component a PCH only when its header exists at configure time
+        echo "PRECOMPILED_HEADER_DIR=$PCH_DIR"
+        echo "PRECOMPILED_HEADERS=$(cd "$PCH_DIR" && echo *.h)"
+    fi
+}
+
+# Precompiled headers, one per component, from the includes most of its sources share. Their
+# directory is keyed by target, IDF version, CMake build type and toolchain version: another
+# toolchain gets another path, so the next configure compiles fresh PCHs instead of reusing
+# incompatible ones. Components from outside the project are known from the last configure.
+PCH_DIR=""
+if [ "$PCH_BUILD" = "1" ]; then
+    phase_begin
+    PCH_KEY="$IDF_TARGET-${IDF_VERSION//[\/.]/_}-$CMAKE_BUILD_TYPE_NAME-$(toolchain_compiler)-$(toolchain_version)"
+    PCH_DIR="$BUILD_TREE/pch/$PCH_KEY"
+    if python3 "$SCRIPT_DIR/pch_headers.py" "$PROJECT_DIR" --output-dir "$PCH_DIR" --key "$PCH_KEY" \
+        --project-description "$BUILD_TREE/project_description.json" \
+        --min-share "$(get_build_type_config_value "$BUILD_TYPE" pch_min_share 0.3)" \
+        --max-headers "$(get_build_type_config_value "$BUILD_TYPE" pch_max_headers 16)"; then
+        echo "Precompiled headers: $PCH_DIR ($(cd "$PCH_DIR" && echo *.h))"
+    else
+        echo "WARNING: No precompiled header generated, building without it"
+        PCH_DIR=""
+    fi
+    phase_end pch
+fi
+
+FINGERPRINT_FILE="$BUILD_TREE/.build_fingerprint"
+CURRENT_FINGERPRINT=$(compute_build_fingerprint)
+
+RECONFIGURE=1
+if [ "$SHARED_BUILD" = "1" ] && [ -f "$FINGERPRINT_FILE" ] && ! grep -qx "APP_TYPE=$APP_TYPE" "$FINGERPRINT_FILE"; then
+    echo "Shared tree last configured for $(sed -n 's/^APP_TYPE=//p' "$FINGERPRINT_FILE"): reconfiguring it for $APP_TYPE"
+fi
+if [ "$FORCE_RECONFIGURE" != "1" ] && [ -f "$BUILD_TREE/CMakeCache.txt" ] && [ -f "$BUILD_TREE/build.ninja" ] \
+   && [ -f "$FINGERPRINT_FILE" ] && [ "$(< "$FINGERPRINT_FILE")" = "$CURRENT_FINGERPRINT" ]; then
+    RECONFIGURE=0
+fi
+
+# Seed a new build tree from a configured sibling with the same ESP-IDF checkout, toolchain,
+# target and sdkconfig (fingerprints equal apart from APP_TYPE/BUILD_TYPE). The CMake caches
+# (with the compiler detection in CMakeFiles/) of the project and the bootloader subproject are
+# copied, or reflinked where the filesystem supports it, and their paths rewritten, so the
+# following configure is a warm re-run instead of a cold first configure.
+clone_sibling_build_tree() {
+    local wanted
+    wanted=$(grep -v '^APP_TYPE=\|^BUILD_TYPE=' <<< "$CURRENT_FINGERPRINT")
+
+    local candidate source="" fingerprint
+    for candidate in "$PROJECT_DIR"/*/.build_fingerprint ${RAM_BUILD_ROOT:+"$RAM_BUILD_ROOT"/*/.build_fingerprint}; do
+        candidate="${candidate%/.build_fingerprint}"
+        if [ "$candidate" = "$BUILD_TREE" ] || [ ! -f "$candidate/CMakeCache.txt" ] || [ ! -f "$candidate/build.ninja" ]; then
+            continue
+        fi
+        fingerprint=$(< "$candidate/.build_fingerprint")
+        if [ "$(grep -v '^APP_TYPE=\|^BUILD_TYPE=' <<< "$fingerprint")" != "$wanted" ]; then
+            continue
+        fi
+        # Prefer a sibling of the same build type (identical cache apart from the app)
+        source="$candidate"
+        if grep -qx "BUILD_TYPE=$BUILD_TYPE" <<< "$fingerprint"; then
+            break
+        fi
+    done
+    if [ -z "$source" ]; then
+        return 1
+    fi
+
+    echo "Cloning configured build tree from $(basename "$source")..."
+    local subdir items escaped_source escaped_tree
+    escaped_source=$(printf '%s' "$source" | sed 's/[][\.*^$|]/\\&/g')
+    escaped_tree=$(printf '%s' "$BUILD_TREE" | sed 's/[\&|]/\\&/g')
+    for subdir in "" bootloader; do
+        if [ ! -f "$source/$subdir/CMakeCache.txt" ]; then
+            continue
+        fi
+        mkdir -p "$BUILD_TREE/$subdir"
+        items=("$source/$subdir/CMakeCache.txt")
+        if [ -d "$source/$subdir/CMakeFiles" ]; then
+            items+=("$source/$subdir/CMakeFiles")
+        fi
+        cp -a --reflink=auto "${items[@]}" "$BUILD_TREE/$subdir/" 2>/dev/null || cp -a "${items[@]}" "$BUILD_TREE/$subdir/"
+        # CMake refuses a cache created in another directory
+        sed -i.bak -e "s|$escaped_source|$escaped_tree|g" \
+            -e "s|^APP_TYPE:\([A-Z]*\)=.*|APP_TYPE:\1=$APP_TYPE|" \
+            -e "s|^BUILD_TYPE:\([A-Z]*\)=.*|BUILD_TYPE:\1=$BUILD_TYPE|" \
+            -e "s|^CMAKE_BUILD_TYPE:\([A-Z]*\)=.*|CMAKE_BUILD_TYPE:\1=$CMAKE_BUILD_TYPE_NAME|" \
+            "$BUILD_TREE/$subdir/CMakeCache.txt"
+        rm -f "$BUILD_TREE/$subdir/CMakeCache.txt.bak"
+    done
+    return 0
+}
+
+# Path-independent ccache: build directory names embed app, build type, target and IDF version,
+# and CI workspaces differ, so absolute paths never match across builds. Paths below a base
+# directory shared by the project and ESP-IDF are hashed relative, the working directory is left
+# out of the hash and the compiler is identified by toolchain version instead of its mtime.
+# Identical translation units then hit across build directories and machines. Variables the
+# user already set win. Each build's results go to a stats log for the hit/miss delta.
+setup_ccache() {
+    local base_dir candidate idf_real
+    base_dir=$(cd "$PROJECT_DIR" && pwd -P)
+    if [ -n "$IDF_PATH" ] && idf_real=$(cd "$IDF_PATH" 2>/dev/null && pwd -P); then
+        candidate="$base_dir"
+        while [ "$candidate" != "/" ] && [[ "$idf_real/" != "$candidate/"* ]]; do
+            candidate=$(dirname "$candidate")
+        done
+        # "/" would make every path relative: keep the project directory then
+        if [ "$candidate" != "/" ]; then
+            base_dir="$candidate"
+        fi
+    fi
+
+    local toolchain_version
+    toolchain_version=$(toolchain_version)
+
+    export CCACHE_BASEDIR="${CCACHE_BASEDIR:-$base_dir}"
+    export CCACHE_NOHASHDIR="${CCACHE_NOHASHDIR:-1}"
+    export CCACHE_COMPILERCHECK="${CCACHE_COMPILERCHECK:-string:$toolchain_version}"
+    export CCACHE_NAMESPACE="${CCACHE_NAMESPACE:-$(toolchain_compiler)-$toolchain_version}"
+    # Units compiled with a PCH are only cacheable with these sloppiness settings
+    if [ -n "$PCH_DIR" ]; then
+        export CCACHE_SLOPPINESS="${CCACHE_SLOPPINESS:-pch_defines,time_macros}"
+    fi
+    export CCACHE_STATSLOG="$BUILD_TREE/ccache_stats.log"
+    mkdir -p "$BUILD_TREE"
+    : > "$CCACHE_STATSLOG"
+    echo "ccache: base_dir=$CCACHE_BASEDIR, namespace=$CCACHE_NAMESPACE"
+}
+
+# Hits and misses of this build from the stats log (ccache 4.0+; zero without compilations)
+count_ccache_stats() {
+    CCACHE_HITS=$(grep -cx 'direct_cache_hit\|preprocessed_cache_hit' "$CCACHE_STATSLOG" 2>/dev/null || true)
+    CCACHE_MISSES=$(grep -cx 'cache_miss' "$CCACHE_STATSLOG" 2>/dev/null || true)
+    CCACHE_HITS=${CCACHE_HITS:-0}
+    CCACHE_MISSES=${CCACHE_MISSES:-0}
+}
+
+# Helpful metadata for your PR summarizer job (size.info) and map/ELF pointers (size.meta)
+write_size_metadata() {
+  {
+    echo "ELF_FILE=$BUILD_DIR/$PROJECT_NAME.elf"
+    echo "MAP_FILE=$BUILD_DIR/$PROJECT_NAME.map"
+  } > "$BUILD_DIR/size.meta"
+  {
+    echo "APP=$APP_TYPE"
+    echo "BUILD=$BUILD_TYPE"
+    echo "IDF=$IDF_VERSION"
+    echo "TARGET=$IDF_TARGET"
+    echo "PROJECT_NAME=$PROJECT_NAME"
+    echo "BUILD_DIR=$BUILD_DIR"
+    if [ -n "$CCACHE_HITS" ]; then
+      echo "CCACHE_HITS=$CCACHE_HITS"
+      echo "CCACHE_MISSES=$CCACHE_MISSES"
+    fi
+  } > "$BUILD_DIR/size.info"
+}
+
+# size.json keeps ESP-IDF's idf.py size-json format for CI scripts and dashboards reading it
+# (size_report.py writes its own summary to size_report.json); only rerun when size_report.py
+# re-analyzed the ELF since (size.cache rewritten)
+write_idf_size_json() {
+  if [ "$BUILD_DIR/size.json" -nt "$BUILD_DIR/size.cache" ] || [ ! -f "$BUILD_TREE/build.ninja" ]; then
+    return 0
+  fi
+  if run_idf_py -B "$BUILD_TREE" size-json > "$BUILD_DIR/size.json.tmp" 2>/dev/null; then
+    mv "$BUILD_DIR/size.json.tmp" "$BUILD_DIR/size.json"
+  else
+    rm -f "$BUILD_DIR/size.json.tmp"
+    echo "WARNING: idf.py size-json failed: size.json not updated"
+  fi
+}
+
+# Watch mode (--watch): this process keeps the resolved configuration and ESP-IDF environment
+# and reruns only the incremental ninja step when the app's sources change.
+WATCH_DEBOUNCE=${WATCH_DEBOUNCE:-0.3}
+
+# Directories to watch recursively: the app's source file and the project's own components
+# (ESP-IDF and managed components only change through a reconfigure)
+watch_directories() {
+    local source_path dir
+    source_path=$(find "$PROJECT_DIR/main" -name "$SOURCE_FILE" -print -quit 2>/dev/null)
+    if [ -n "$source_path" ]; then
+        dirname "$source_path"
+    fi
+    python3 -c 'import json, sys; print("\n".join(json.load(open(sys.argv[1])).get("build_component_paths", [])))' \
+        "$BUILD_TREE/project_description.json" 2>/dev/null | while read -r dir; do
+        case "$dir" in
+            "$IDF_PATH"/*|*/managed_components/*|"") ;;
+            *) echo "$dir" ;;
+        esac
+    done
+    for dir in "$PROJECT_DIR/main" "$PROJECT_DIR/components"; do
+        if [ -d "$dir" ]; then
+            echo "$dir"
+        fi
+    done
+}
+
+# Print changed paths, one per line: inotifywait when installed, else a once-a-second scan
+watch_events() {
+    if command -v inotifywait &> /dev/null; then
+        trap 'kill $(jobs -p) 2>/dev/null; exit 0' TERM EXIT
+        inotifywait -m -q -r -e close_write,create,delete,move --format '%w%f' \
+            --exclude '(/\.|~$|\.sw[px]$)' "$@" &
+        inotifywait -m -q -e close_write,create,move --format '%w%f' "$PROJECT_DIR" &
+        wait
+    else
+        local stamp="$BUILD_TREE/.watch_stamp"
+        touch "$stamp"
+        while sleep 1; do
+            find "$PROJECT_DIR" -maxdepth 1 -type f -newer "$stamp" -print 2>/dev/null
+            find "$@" -type f -newer "$stamp" -not -name '.*' -print 2>/dev/null
+            touch "$stamp"
+        done
+    fi
+}
+
+# Configuration inputs: a change restarts the script so everything is resolved again
+# (ninja itself reruns CMake for edited CMakeLists.txt files)
+watch_is_config() {
+    case "$1" in
+        "$PROJECT_DIR/app_config.yml"|"$PROJECT_DIR"/sdkconfig.defaults*) return 0 ;;
+    esac
+    return 1
+}
+
+# Flash only the app partition (bootloader and partition table are unchanged by an edit);
+# with DIFF_FLASH=1 only its changed sectors
+watch_flash() {
+    echo "[watch] Flashing app partition to $WATCH_FLASH_PORT..."
+    if [ "$DIFF_FLASH" = "1" ] && python3 "$SCRIPT_DIR/flash_diff.py" "$BUILD_TREE" --app-only \
+        --port "$WATCH_FLASH_PORT" --chip "$IDF_TARGET"; then
+        return
+    fi
+    if [ -f "$BUILD_TREE/flash_app_args" ]; then
+        local esptool=(python3 -m esptool)
+        if command -v esptool.py &> /dev/null; then
+            esptool=(esptool.py)
+        fi
+        (cd "$BUILD_TREE" && "${esptool[@]}" --chip "$IDF_TARGET" -p "$WATCH_FLASH_PORT" \
+            -b "${ESPBAUD:-460800}" --before default_reset --after hard_reset write_flash @flash_app_args)
+    else
+        run_idf_py -B "$BUILD_TREE" -p "$WATCH_FLASH_PORT" app-flash
+    fi || echo "[watch] Flash failed"
+}
+
+watch_rebuild() {
+    local started=$EPOCHREALTIME
+    local build=(ninja -C "$BUILD_TREE")
+    if ! command -v ninja &> /dev/null; then
+        build=(cmake --build "$BUILD_TREE")
+    fi
+    if [ -n "$BUILD_JOBS" ]; then
+        build+=(-j "$BUILD_JOBS")
+    fi
+    if [ -n "$CCACHE_STATSLOG" ]; then
+        : > "$CCACHE_STATSLOG"
+    fi
+    if ! "${build[@]}"; then
+        echo "[watch] Build failed - waiting for the next change"
+        return 0
+    fi
+    if [ -n "$CCACHE_STATSLOG" ]; then
+        count_ccache_stats
+    fi
+    if [ "$BUILD_TREE" != "$BUILD_DIR" ]; then
+        copy_build_tree_outputs
+    fi
+    if python3 "$SCRIPT_DIR/size_report.py" "$BUILD_DIR" --project-name "$PROJECT_NAME" --print none; then
+        write_size_metadata
+        write_idf_size_json
+    fi
+    echo "[watch] Rebuilt in $(awk "BEGIN { printf \"%.1f\", $EPOCHREALTIME - $started }")s${CCACHE_HITS:+ (ccache: $CCACHE_HITS hits, $CCACHE_MISSES misses)}"
+    if [ -n "$WATCH_FLASH_PORT" ]; then
+        watch_flash
+    fi
+}
+
+watch_loop() {
+    local dirs path changed restart
+    mapfile -t dirs < <(watch_directories | sort -u)
+    if [ ${#dirs[@]} -eq 0 ]; then
+        echo "ERROR: No source directories to watch for $APP_TYPE" >&2
+        exit 1
+    fi
+    # The up-to-date fast path returns before ccache is set up; rebuilds need the same settings
+    if [ "$USE_CCACHE" = "1" ] && [ -z "$CCACHE_STATSLOG" ] && command -v ccache &> /dev/null; then
+        setup_ccache
+    fi
+    if [ -n "$WATCH_FLASH_PORT" ] && [ -f "$BUILD_DIR/$PROJECT_NAME.bin" ]; then
+        watch_flash
+    fi
+    echo "======================================================"
+    echo "WATCHING $APP_TYPE ($BUILD_TYPE) - Ctrl+C to stop"
+    echo "======================================================"
+    printf '  %s\n' "${dirs[@]#$PROJECT_DIR/}" "app_config.yml" "sdkconfig.defaults*"
+    if ! command -v inotifywait &> /dev/null; then
+        echo "inotifywait not found (inotify-tools): polling once a second"
+    fi
+
+    exec {WATCH_FD}< <(watch_events "${dirs[@]}")
+    local watcher=$!
+    while read -r -u "$WATCH_FD" path; do
+        # Top-level project files other than the configuration are not build inputs
+        if [ "$(dirname "$path")" = "$PROJECT_DIR" ] && ! watch_is_config "$path"; then
+            continue
+        fi
+        changed="$path"
+        restart=0
+        watch_is_config "$path" && restart=1
+        # Debounce: editors and git checkouts write several files in a burst
+        while read -r -u "$WATCH_FD" -t "$WATCH_DEBOUNCE" path; do
+            watch_is_config "$path" && restart=1
+        done
+        echo ""
+        echo "[watch] $(date +%H:%M:%S) changed: ${changed#$PROJECT_DIR/}"
+        if [ "$restart" = "1" ]; then
+            echo "[watch] Configuration changed - restarting"
+            kill "$watcher" 2>/dev/null || true
+            exec "$SCRIPT_DIR/build_app.sh" "${ORIGINAL_ARGS[@]}"
+        fi
+        watch_rebuild
+    done
+    exit 0
+}
+
+# True when ninja has no edge to run for the app's own outputs. A dry run of the whole tree always
+# lists work: the bootloader subproject is built with BUILD_ALWAYS and size checks are custom
+# targets that run on every build. So only the ELF, the .bin (.bin_timestamp in ESP-IDF 5.x)
+# and the partition table are asked for.
+app_outputs_up_to_date() {
+    local targets=("$PROJECT_NAME.elf") target plan
+    for target in .bin_timestamp "$PROJECT_NAME.bin" partition_table/partition-table.bin; do
+        if ninja -C "$BUILD_TREE" -t query "$target" &> /dev/null; then
+            targets+=("$target")
+        fi
+    done
+    plan=$(ninja -C "$BUILD_TREE" -n "${targets[@]}" 2>/dev/null) || return 1
+    ! grep -q '^\[' <<< "$plan"
+}
+
+if [ "$RECONFIGURE" = "0" ]; then
+    echo "Build inputs unchanged: skipping CMake configure (use --reconfigure to force)"
+
+    # Nothing to rebuild either: report the existing build and stop here
+    if [ "$PROFILE_COMPILE" != "1" ] && [ -f "$BUILD_DIR/$PROJECT_NAME.bin" ] && command -v ninja &> /dev/null \
+       && app_outputs_up_to_date; then
+        export ESP32_BUILD_APP_MOST_RECENT_DIRECTORY="$BUILD_DIR"
+        echo "ESP32_BUILD_APP_MOST_RECENT_DIRECTORY=$BUILD_DIR"
+        echo "======================================================"
+        echo "BUILD UP TO DATE - nothing to do"
+        echo "======================================================"
+        echo "Build Directory: $BUILD_DIR"
+        echo "Binary: $BUILD_DIR/$PROJECT_NAME.bin"
+        if [ "$WATCH" = "1" ]; then
+            watch_loop
+        fi
+        exit 0
+    fi
+fi
+
+# Content-addressed artifact cache: restore a build with identical inputs instead of compiling
+ARTIFACT_KEY=""
+if [ "$USE_ARTIFACT_CACHE" != "0" ]; then
+    ARTIFACT_CACHE_ARGS=(--app "$APP_TYPE" --build-type "$BUILD_TYPE" --target "$IDF_TARGET"
+        --idf-version "$IDF_VERSION" --idf-path "$IDF_PATH" --project-dir "$PROJECT_DIR"
+        --project-name "$PROJECT_NAME"
+        --max-size "${ESP32_ARTIFACT_CACHE_SIZE:-$(get_build_config_value artifact_cache_size 5G)}")
+    phase_begin
+    ARTIFACT_STATUS=0
+    ARTIFACT_KEY=$(python3 "$SCRIPT_DIR/artifact_cache.py" restore "$BUILD_DIR" "${ARTIFACT_CACHE_ARGS[@]}") || ARTIFACT_STATUS=$?
+    phase_end artifact_restore
+
+    if [ "$ARTIFACT_STATUS" = "0" ]; then
+        write_size_metadata
+        export ESP32_BUILD_APP_MOST_RECENT_DIRECTORY="$BUILD_DIR"
+        echo "ESP32_BUILD_APP_MOST_RECENT_DIRECTORY=$BUILD_DIR"
+        echo "======================================================"
+        echo "BUILD RESTORED FROM ARTIFACT CACHE"
+        echo "======================================================"
+        echo "Cache Key: $ARTIFACT_KEY"
+        echo "Build Directory: $BUILD_DIR"
+        echo "Binary: $BUILD_DIR/$PROJECT_NAME.bin"
+        echo "Use --no-artifact-cache to compile anyway"
+        exit 0
+    elif [ "$ARTIFACT_STATUS" != "3" ]; then
+        echo "WARNING: Artifact cache unavailable, building without it"
+        ARTIFACT_KEY=""
+    fi
+fi
+
+if [ "$USE_CCACHE" = "1" ] && command -v ccache &> /dev/null; then
+    setup_ccache
+fi
+
 # Configure and build with proper error handling
-echo "Configuring project for $IDF_TARGET..."
+if [ "$RECONFIGURE" = "1" ]; then
+    echo "Configuring project for $IDF_TARGET..."
 
-if ! idf.py -B "$BUILD_DIR" -D CMAKE_BUILD_TYPE="$BUILD_TYPE" -D BUILD_TYPE="$BUILD_TYPE" -D APP_TYPE="$APP_TYPE" -D IDF_CCACHE_ENABLE="$USE_CCACHE" reconfigure; then
-    echo "ERROR: Configuration failed"
-    exit 1
+    # A failed configure must not leave a matching fingerprint behind
+    rm -f "$FINGERPRINT_FILE"
+
+    # New build tree: start from a configured sibling instead of a cold configure
+    if [ ! -f "$BUILD_TREE/CMakeCache.txt" ] && [ "$CLEAN" != "1" ] && [ "$CLONE_BUILD_TREE" != "0" ]; then
+        phase_begin
+        if clone_sibling_build_tree; then
+            phase_end clone
+        fi
+    fi
+
+    phase_begin
+    if ! run_idf_py -B "$BUILD_TREE" -D CMAKE_BUILD_TYPE="$CMAKE_BUILD_TYPE_NAME" -D BUILD_TYPE="$BUILD_TYPE" -D APP_TYPE="$APP_TYPE" \
+        -D UNITY_BUILD="$UNITY_BUILD" -D UNITY_BUILD_BATCH_SIZE="$UNITY_BUILD_BATCH_SIZE" -D PRECOMPILED_HEADER_DIR="$PCH_DIR" \
+        -D IDF_CCACHE_ENABLE="$USE_CCACHE" reconfigure; then
+        echo "ERROR: Configuration failed"
+        exit 1
+    fi
+    phase_end reconfigure
+
+    # Configure regenerates sdkconfig, so fingerprint the state it left behind
+    CURRENT_FINGERPRINT=$(compute_build_fingerprint)
+    echo "$CURRENT_FINGERPRINT" > "$FINGERPRINT_FILE"
 fi
 
 echo "Building project..."
-if ! idf.py -B "$BUILD_DIR" build; then
+if [ -n "$BUILD_JOBS" ]; then
+    # idf.py has no job-count option: run the configured tree's default target with the given budget
+    BUILD_COMMAND=(cmake --build "$BUILD_TREE" -j "$BUILD_JOBS")
+else
+    BUILD_COMMAND=(run_idf_py -B "$BUILD_TREE" build)
+fi
+phase_begin
+if ! "${BUILD_COMMAND[@]}"; then
     echo "ERROR: Build failed"
+    if [ "$WATCH" = "1" ]; then
+        watch_loop
+    fi
     exit 1
 fi
+if [ -n "$CCACHE_STATSLOG" ]; then
+    count_ccache_stats
+fi
+if [ "$BUILD_TREE" != "$BUILD_DIR" ]; then
+    copy_build_tree_outputs
+    echo "Copied $APP_TYPE outputs from $BUILD_TREE to $BUILD_DIR"
+    if [ -n "$SHARED_LOCK_FD" ]; then
+        flock -u "$SHARED_LOCK_FD"
+    fi
+fi
+phase_end build
 
-# Get actual binary information using configuration
-PROJECT_NAME=$(get_project_name "$APP_TYPE")
+# Binary information (PROJECT_NAME resolved by config_query above)
 BIN_FILE="$BUILD_DIR/$PROJECT_NAME.bin"
 
 # Export build directory for CI and other scripts to use
@@ -428,31 +1405,62 @@ echo "======================================================"
 echo "BUILD SIZE INFORMATION"
 echo "======================================================"
 
-# Print and capture size in one call
-if idf.py -B "$BUILD_DIR" size | tee "$BUILD_DIR/size.txt" >/dev/null; then
-  # If supported, also emit JSON for machine parsing
-  if idf.py -B "$BUILD_DIR" size-json >/dev/null 2>&1; then
-    idf.py -B "$BUILD_DIR" size-json > "$BUILD_DIR/size.json" || true
+# One pass over the map file writes size.txt/size_report.json plus the component and symbol
+# reports (cached by ELF hash, so flash_app.sh size only reads them back)
+phase_begin
+if python3 "$SCRIPT_DIR/size_report.py" "$BUILD_DIR" --project-name "$PROJECT_NAME"; then
+  write_size_metadata
+  write_idf_size_json
+else
+  echo "WARNING: Could not display size information"
+fi
+if [ -n "$CCACHE_HITS" ]; then
+  CCACHE_TOTAL=$(( CCACHE_HITS + CCACHE_MISSES ))
+  if [ "$CCACHE_TOTAL" -gt 0 ]; then
+    echo "ccache this build: $CCACHE_HITS hits, $CCACHE_MISSES misses ($(( CCACHE_HITS * 100 / CCACHE_TOTAL ))% hit rate)"
+  else
+    echo "ccache this build: no compilations"
   fi
+fi
+phase_end size
 
-  # (Optional) map/ELF pointers to aid later analysis
-  ELF_FILE="$(find "$BUILD_DIR" -maxdepth 1 -name '*.elf' | head -n1 || true)"
-  MAP_FILE="$(find "$BUILD_DIR" -maxdepth 1 -name '*.map' | head -n1 || true)"
-  [ -n "$ELF_FILE" ] && echo "ELF_FILE=$ELF_FILE" >> "$BUILD_DIR/size.meta"
-  [ -n "$MAP_FILE" ] && echo "MAP_FILE=$MAP_FILE" >> "$BUILD_DIR/size.meta"
+# Front-end profile of the app and wrapper units: same flags, -H and -ftime-report/-ftime-trace
+if [ "$PROFILE_COMPILE" = "1" ]; then
+  echo "======================================================"
+  echo "COMPILE PROFILE"
+  echo "======================================================"
+  phase_begin
+  if python3 "$SCRIPT_DIR/compile_profile.py" "$BUILD_TREE" --project-dir "$PROJECT_DIR" \
+      --output-dir "$BUILD_DIR" ${BUILD_JOBS:+--jobs "$BUILD_JOBS"}; then
+    echo "Details: $BUILD_DIR/compile_profile.txt"
+  else
+    echo "WARNING: Could not write the compile profile"
+  fi
+  phase_end compile_profile
+fi
 
-  # Helpful metadata for your PR summarizer job
-  {
-    echo "APP=$APP_TYPE"
-    echo "BUILD=$BUILD_TYPE"
-    echo "IDF=$IDF_VERSION"
-    echo "TARGET=$IDF_TARGET"
-    echo "PROJECT_NAME=$PROJECT_NAME"
-    echo "BUILD_DIR=$BUILD_DIR"
-  } > "$BUILD_DIR/size.info"
-else
-  echo "WARNING: Could not display size information"
+# Share the result with later builds (key computed from the inputs before compiling)
+if [ -n "$ARTIFACT_KEY" ]; then
+  phase_begin
+  if ! python3 "$SCRIPT_DIR/artifact_cache.py" store "$BUILD_DIR" --key "$ARTIFACT_KEY" "${ARTIFACT_CACHE_ARGS[@]}"; then
+    echo "WARNING: Could not store the build in the artifact cache"
+  fi
+  phase_end artifact_store
+fi
+
+echo "======================================================"
+echo "BUILD PROFILE"
+echo "======================================================"
+
+# Phase timings + .ninja_log -> build_trace.json (Chrome/Perfetto), build_profile.txt/.json
+printf '%s\n' "${BUILD_PHASES[@]}" > "$BUILD_DIR/build_phases.tsv"
+if ! python3 "$SCRIPT_DIR/build_profile.py" "$BUILD_DIR"; then
+  echo "WARNING: Could not write the build profile"
 fi
+echo "Details: $BUILD_DIR/build_profile.txt (trace: build_trace.json)"
 
 echo "======================================================"
 
+if [ "$WATCH" = "1" ]; then
+    watch_loop
+fi
@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Build profiling for ESP32 builds.
+This script combines the per-phase timings recorded by build_app.sh with the
+per-target durations from ninja's .ninja_log and writes a Chrome/Perfetto trace
+plus "slowest translation units" and "slowest components" reports into the
+build directory, next to size.info/size.meta.
+"""
+
+import re
+import sys
+import json
+import argparse
+from pathlib import Path
+
+PHASES_NAME = "build_phases.tsv"
+TRACE_NAME = "build_trace.json"
+PROFILE_TEXT_NAME = "build_profile.txt"
+PROFILE_JSON_NAME = "build_profile.json"
+
+DEFAULT_TOP = 20
+
+COMPONENT_DIR_RE = re.compile(r'__idf_([^/]+)\.dir/')
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Build Profiler")
+    print("")
+    print("Usage: python3 build_profile.py <build_dir> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print(f"  --phases <file>             - Phase timings from build_app.sh (default: <build_dir>/{PHASES_NAME})")
+    print(f"  --top <n>                   - Rows in the slowest TU/component tables (default: {DEFAULT_TOP})")
+    print("  --all-runs                  - Profile every run recorded in .ninja_log, not only the last one")
+    print("  --print <report>            - Print summary (phases + ninja), all or none (default: summary)")
+    print("")
+    print("OUTPUT FILES (in build_dir):")
+    print(f"  • {TRACE_NAME}: Chrome trace (chrome://tracing, https://ui.perfetto.dev)")
+    print(f"  • {PROFILE_TEXT_NAME}: phases, slowest translation units and components")
+    print(f"  • {PROFILE_JSON_NAME}: the same data as JSON")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 build_profile.py ../build-app-gpio_test-type-Release-target-esp32c6-idf-release_v5_5")
+    print("  python3 build_profile.py <build_dir> --top 50 --print all")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Build phase and ninja log profiling",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_dir", nargs="?", help="Build directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--phases", help="Phase timing file")
+    parser.add_argument("--top", type=int, default=DEFAULT_TOP, help="Rows in the report tables")
+    parser.add_argument("--all-runs", action="store_true", help="Profile every recorded ninja run")
+    parser.add_argument("--print", dest="print_report", choices=["summary", "all", "none"], default="summary",
+                        help="Report to print")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_dir:
+        show_help()
+
+    return args
+
+def read_phases(phases_file):
+    """Read name<TAB>start<TAB>end lines (epoch seconds) written by build_app.sh."""
+    phases = []
+    try:
+        with open(phases_file) as f:
+            for line in f:
+                fields = line.rstrip('\n').split('\t')
+                if len(fields) == 3:
+                    phases.append({'name': fields[0], 'start': float(fields[1]), 'end': float(fields[2])})
+    except (OSError, ValueError):
+        return []
+    return phases
+
+def read_ninja_log(ninja_log, all_runs=False):
+    """Parse .ninja_log (v5+) into edges of the last run (or of every run)."""
+    runs = [[]]
+    seen = set()
+    last_end = -1
+    try:
+        with open(ninja_log) as f:
+            header = f.readline()
+            if not header.startswith('# ninja log v'):
+                return []
+            for line in f:
+                fields = line.rstrip('\n').split('\t')
+                if len(fields) < 5:
+                    continue
+                start, end, output, command_hash = int(fields[0]), int(fields[1]), fields[3], fields[4]
+                # Ends grow within one ninja run; a smaller end means a new run started
+                if end < last_end:
+                    runs.append([])
+                    seen = set()
+                last_end = end
+                # Edges with several outputs appear once per output
+                key = (start, end, command_hash)
+                if key in seen:
+                    continue
+                seen.add(key)
+                runs[-1].append({'start_ms': start, 'end_ms': end, 'output': output})
+    except (OSError, ValueError):
+        return []
+    if all_runs:
+        return [edge for run in runs for edge in run]
+    return runs[-1]
+
+def load_component_origins(build_dir):
+    """Map component name -> project/idf/managed from project_description.json."""
+    try:
+        with open(build_dir / "project_description.json") as f:
+            description = json.load(f)
+    except (OSError, ValueError):
+        return {}
+    project_path = description.get('project_path', '')
+    origins = {}
+    for name, info in (description.get('build_component_info') or {}).items():
+        component_dir = info.get('dir', '') or ''
+        if 'managed_components' in component_dir:
+            origins[name] = 'managed'
+        elif project_path and component_dir.startswith(project_path):
+            origins[name] = 'project'
+        else:
+            origins[name] = 'idf'
+    return origins
+
+def classify(output):
+    """Kind of a ninja output: compile, archive, link, image or other."""
+    if output.endswith(('.obj', '.o')):
+        return 'compile'
+    if output.endswith('.a'):
+        return 'archive'
+    if output.endswith('.elf'):
+        return 'link'
+    if output.endswith('.bin'):
+        return 'image'
+    return 'other'
+
+def component_of(output):
+    """Component an output belongs to (from the __idf_<name>.dir CMake target directory)."""
+    match = COMPONENT_DIR_RE.search(output)
+    if match:
+        return match.group(1)
+    return '(project)'
+
+def summarize(edges, origins):
+    """Per-kind spans, slowest translation units and per-component compile time."""
+    kinds = {}
+    for edge in edges:
+        kind = kinds.setdefault(classify(edge['output']), {'count': 0, 'cpu_ms': 0, 'start_ms': None, 'end_ms': 0})
+        kind['count'] += 1
+        kind['cpu_ms'] += edge['end_ms'] - edge['start_ms']
+        kind['start_ms'] = edge['start_ms'] if kind['start_ms'] is None else min(kind['start_ms'], edge['start_ms'])
+        kind['end_ms'] = max(kind['end_ms'], edge['end_ms'])
+    for kind in kinds.values():
+        kind['span_ms'] = kind['end_ms'] - kind['start_ms']
+
+    units = []
+    components = {}
+    for edge in edges:
+        if classify(edge['output']) != 'compile':
+            continue
+        duration = edge['end_ms'] - edge['start_ms']
+        component = component_of(edge['output'])
+        units.append({'output': edge['output'], 'component': component, 'duration_ms': duration})
+        stats = components.setdefault(component, {'units': 0, 'cpu_ms': 0,
+                                                  'origin': origins.get(component, 'unknown')})
+        stats['units'] += 1
+        stats['cpu_ms'] += duration
+
+    units.sort(key=lambda unit: -unit['duration_ms'])
+    ordered = dict(sorted(components.items(), key=lambda item: -item[1]['cpu_ms']))
+    origin_totals = {}
+    for stats in ordered.values():
+        origin_totals[stats['origin']] = origin_totals.get(stats['origin'], 0) + stats['cpu_ms']
+
+    span_ms = max((edge['end_ms'] for edge in edges), default=0) - min((edge['start_ms'] for edge in edges), default=0)
+    return {
+        'ninja_span_ms': span_ms,
+        'kinds': kinds,
+        'translation_units': units,
+        'components': ordered,
+        'origin_cpu_ms': origin_totals,
+    }
+
+def phase_report(phases, ninja_span_ms):
+    """Phase durations plus the wrapper overhead not spent in IDF tools."""
+    if not phases:
+        return {}, None
+    durations = {}
+    for phase in phases:
+        durations[phase['name']] = round((phase['end'] - phase['start']) * 1000)
+    total_ms = round((max(p['end'] for p in phases) - min(p['start'] for p in phases)) * 1000)
+    tool_ms = sum(durations.get(name, 0) for name in ('idf_export', 'reconfigure', 'size'))
+    # The build phase minus ninja's own span is idf.py startup and checks
+    tool_ms += min(durations.get('build', 0), ninja_span_ms) if ninja_span_ms else durations.get('build', 0)
+    durations['total'] = total_ms
+    return durations, max(total_ms - tool_ms, 0)
+
+def build_trace(phases, edges):
+    """Chrome trace: build_app.sh phases on one thread, ninja edges packed into lanes."""
+    events = [{'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'build_app.sh'}},
+              {'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 0, 'args': {'name': 'phases'}}]
+    origin = min((p['start'] for p in phases), default=0)
+    for phase in phases:
+        events.append({'name': phase['name'], 'cat': 'phase', 'ph': 'X', 'pid': 1, 'tid': 0,
+                       'ts': round((phase['start'] - origin) * 1e6),
+                       'dur': round((phase['end'] - phase['start']) * 1e6)})
+
+    # Ninja times are relative to its own start, which is (about) the start of the build phase
+    build_phase = next((p for p in phases if p['name'] == 'build'), None)
+    offset_us = round((build_phase['start'] - origin) * 1e6) if build_phase else 0
+
+    lanes = []  # end time of the last edge in each lane
+    for edge in sorted(edges, key=lambda e: (e['start_ms'], e['end_ms'])):
+        for lane, lane_end in enumerate(lanes):
+            if lane_end <= edge['start_ms']:
+                break
+        else:
+            lane = len(lanes)
+            lanes.append(0)
+        lanes[lane] = edge['end_ms']
+        events.append({'name': Path(edge['output']).name, 'cat': classify(edge['output']), 'ph': 'X',
+                       'pid': 1, 'tid': lane + 1, 'ts': offset_us + edge['start_ms'] * 1000,
+                       'dur': (edge['end_ms'] - edge['start_ms']) * 1000,
+                       'args': {'output': edge['output'], 'component': component_of(edge['output'])}})
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+def format_seconds(ms):
+    return f"{ms / 1000:.2f}s"
+
+def format_summary(durations, overhead_ms, summary):
+    """Text summary: phases and ninja breakdown."""
+    lines = ["=== Build Phases ==="]
+    for name, ms in durations.items():
+        lines.append(f"{name:<24}{format_seconds(ms):>10}")
+    if overhead_ms is not None:
+        lines.append(f"{'wrapper overhead':<24}{format_seconds(overhead_ms):>10}")
+
+    lines.append("")
+    lines.append(f"=== Ninja ({format_seconds(summary['ninja_span_ms'])} wall) ===")
+    lines.append(f"{'Kind':<12}{'Edges':>8}{'Wall span':>12}{'CPU time':>12}")
+    for name, kind in sorted(summary['kinds'].items()):
+        lines.append(f"{name:<12}{kind['count']:>8}{format_seconds(kind['span_ms']):>12}"
+                     f"{format_seconds(kind['cpu_ms']):>12}")
+    if summary['origin_cpu_ms']:
+        lines.append("Compile CPU time by origin: " + ", ".join(
+            f"{origin} {format_seconds(ms)}" for origin, ms in sorted(summary['origin_cpu_ms'].items())))
+    return "\n".join(lines) + "\n"
+
+def format_details(summary, top):
+    """Text details: slowest translation units and components."""
+    lines = [f"=== Slowest Translation Units (top {top}) ==="]
+    for unit in summary['translation_units'][:top]:
+        lines.append(f"{format_seconds(unit['duration_ms']):>10}  {unit['component']:<24}{Path(unit['output']).name}")
+
+    lines.append("")
+    lines.append(f"=== Slowest Components (top {top}, compile CPU time) ===")
+    lines.append(f"{'Component':<32}{'Origin':<10}{'TUs':>6}{'CPU time':>12}")
+    for name, stats in list(summary['components'].items())[:top]:
+        lines.append(f"{name:<32}{stats['origin']:<10}{stats['units']:>6}{format_seconds(stats['cpu_ms']):>12}")
+    return "\n".join(lines) + "\n"
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    build_dir = Path(args.build_dir).resolve()
+    if not build_dir.is_dir():
+        print(f"Error: Build directory not found: {build_dir}", file=sys.stderr)
+        sys.exit(1)
+
+    phases = read_phases(Path(args.phases) if args.phases else build_dir / PHASES_NAME)
+    edges = read_ninja_log(build_dir / ".ninja_log", args.all_runs)
+    summary = summarize(edges, load_component_origins(build_dir))
+    durations, overhead_ms = phase_report(phases, summary['ninja_span_ms'])
+    text_summary = format_summary(durations, overhead_ms, summary)
+    report = text_summary + "\n" + format_details(summary, args.top)
+
+    try:
+        (build_dir / TRACE_NAME).write_text(json.dumps(build_trace(phases, edges)) + "\n")
+        (build_dir / PROFILE_TEXT_NAME).write_text(report)
+        (build_dir / PROFILE_JSON_NAME).write_text(json.dumps({
+            'phases_ms': durations,
+            'wrapper_overhead_ms': overhead_ms,
+            **summary,
+        }, indent=2) + "\n")
+    except OSError as e:
+        print(f"Error writing build profile: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if args.print_report == 'all':
+        sys.stdout.write(report)
+    elif args.print_report == 'summary':
+        sys.stdout.write(text_summary)
+
+if __name__ == '__main__':
+    main()
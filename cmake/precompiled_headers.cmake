@@ -0,0 +1,32 @@
+# Precompiled headers for the HardFOC app and wrapper components.
+#
+# Build types with "precompiled_headers: true" in build_config.build_types make build_app.sh
+# generate one header per component of the includes most of that component's sources share
+# (pch_headers.py) and configure with -D PRECOMPILED_HEADER_DIR=<dir>. The directory is keyed by
+# target, IDF version, build type and toolchain version, so a PCH is never reused with another
+# compiler. Components opt in after registering themselves:
+#
+#   include(${CMAKE_SOURCE_DIR}/scripts/cmake/precompiled_headers.cmake)
+#   idf_component_register(SRCS ${APP_SOURCES} ...)
+#   hf_precompile_headers(${COMPONENT_LIB})
+#
+# The component's own header (<dir>/${COMPONENT_NAME}.h) only holds headers its sources include,
+# so it resolves with the component's include directories and REQUIRES. A component without a
+# header (too few shared includes) builds without a PCH. ESP-IDF's own components are left alone.
+
+function(hf_precompile_headers target)
+    # ESP-IDF evaluates component CMakeLists.txt once in script mode to expand requirements
+    if(CMAKE_BUILD_EARLY_EXPANSION OR NOT TARGET ${target} OR NOT PRECOMPILED_HEADER_DIR)
+        return()
+    endif()
+
+    set(header "${PRECOMPILED_HEADER_DIR}/${COMPONENT_NAME}.h")
+    if(NOT EXISTS "${header}")
+        return()
+    endif()
+
+    target_precompile_headers(${target} PRIVATE "${header}")
+    # Warn when GCC rejects the PCH (e.g. mismatching flags) instead of silently parsing again;
+    # -fpch-preprocess lets ccache cache units that use it (with sloppiness pch_defines,time_macros)
+    target_compile_options(${target} PRIVATE -Winvalid-pch -fpch-preprocess)
+endfunction()
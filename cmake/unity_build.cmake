@@ -0,0 +1,34 @@
+# Unity (jumbo) build for the HardFOC app and wrapper components.
+#
+# Build types with "unity_build: true" in build_config.build_types make build_app.sh configure with
+# -D UNITY_BUILD=ON -D UNITY_BUILD_BATCH_SIZE=<unity_batch_size>. Components opt in after
+# registering themselves; sources that cannot share a translation unit (conflicting file-local
+# names or macros) are listed after EXCLUDE and keep compiling on their own:
+#
+#   include(${CMAKE_SOURCE_DIR}/scripts/cmake/unity_build.cmake)
+#   idf_component_register(SRCS ${APP_SOURCES} ...)
+#   hf_unity_build(${COMPONENT_LIB} EXCLUDE src/LegacyDriver.cpp)
+#
+# ESP-IDF's own components are deliberately left alone: many of them rely on file-local static
+# names that collide when merged.
+
+function(hf_unity_build target)
+    # ESP-IDF evaluates component CMakeLists.txt once in script mode to expand requirements
+    if(CMAKE_BUILD_EARLY_EXPANSION OR NOT TARGET ${target} OR NOT UNITY_BUILD)
+        return()
+    endif()
+
+    cmake_parse_arguments(ARG "" "" "EXCLUDE" ${ARGN})
+    if(NOT UNITY_BUILD_BATCH_SIZE)
+        set(UNITY_BUILD_BATCH_SIZE 8)
+    endif()
+
+    set_target_properties(${target} PROPERTIES
+        UNITY_BUILD ON
+        UNITY_BUILD_MODE BATCH
+        UNITY_BUILD_BATCH_SIZE ${UNITY_BUILD_BATCH_SIZE})
+
+    if(ARG_EXCLUDE)
+        set_source_files_properties(${ARG_EXCLUDE} PROPERTIES SKIP_UNITY_BUILD_INCLUSION ON)
+    endif()
+endfunction()
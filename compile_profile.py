@@ -0,0 +1,379 @@
+#!/usr/bin/env python3
+"""
+Compile-time attribution for the HardFOC app and wrapper sources.
+Re-runs the front end of every project translation unit from the build tree's
+compile_commands.json with the same flags, without touching the build outputs:
+GCC with -H -ftime-report (plus one isolated parse per candidate header, GCC has
+no per-header timing), clang with -H -ftime-trace (per-header "Source" events).
+Writes compile_profile.txt/.json into the build directory: the slowest units
+and the most expensive headers, with the parse time attributed to each, the
+units that include them and the files with the #include line to change.
+"""
+
+import os
+import re
+import sys
+import json
+import shlex
+import argparse
+import tempfile
+import subprocess
+from pathlib import Path
+from concurrent.futures import ThreadPoolExecutor
+
+from flash_fast import component_dirs, load_project_description
+
+PROFILE_TEXT_NAME = "compile_profile.txt"
+PROFILE_JSON_NAME = "compile_profile.json"
+
+DEFAULT_TOP = 20
+DEFAULT_MAX_HEADERS = 40    # Isolated header parses (GCC only)
+
+# Compiler launchers CMake may put in front of the compiler
+LAUNCHERS = {"ccache", "sccache"}
+# Options that produce outputs; dropped (with their value) for the front-end-only run
+DROP_FLAGS = {"-c", "-MD", "-MMD", "-MP"}
+DROP_FLAGS_WITH_VALUE = {"-o", "-MF", "-MT", "-MQ"}
+# Directories under the source directories that do not hold project sources
+FOREIGN_DIRS = {"managed_components"}
+
+INCLUDE_TRACE_RE = re.compile(r'^(\.+) (.+)$')
+# GCC -ftime-report: " phase parsing : 0.21 ( 75%) 0.08 ( 89%) 0.30 ( 77%) 25M ( 90%)" (usr sys wall)
+TIME_REPORT_RE = re.compile(r'^\s*(.+?)\s*:\s*([\d.]+)\s*(?:\(\s*\d+%\))?\s+([\d.]+)\s*(?:\(\s*\d+%\))?\s+([\d.]+)')
+GCC_PARSE_PHASES = ("phase parsing", "phase lang. deferred")
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Compile-Time Attribution")
+    print("")
+    print("Usage: python3 compile_profile.py <build_tree> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --project-dir <dir>         - Project directory (default: project_path of project_description.json)")
+    print("  --output-dir <dir>          - Where to write the reports (default: the build tree)")
+    print("  --jobs <n>                  - Concurrent compiler runs (default: CPU count)")
+    print(f"  --top <n>                   - Rows in the unit and header tables (default: {DEFAULT_TOP})")
+    print(f"  --max-headers <n>           - Headers parsed in isolation with GCC (default: {DEFAULT_MAX_HEADERS})")
+    print("  --print <report>            - Print summary, all or none (default: summary)")
+    print("")
+    print("MEASUREMENT:")
+    print("  • Units: project sources of compile_commands.json (main/, components/ and external components")
+    print("    such as the wrapper library from build_component_paths), same flags, -fsyntax-only")
+    print("  • GCC: -H include trees and -ftime-report parse time per unit; each candidate header")
+    print("    (included by a project file) is parsed alone with its first includer's flags")
+    print("  • clang: -H include trees and -ftime-trace per-header parse time in every unit")
+    print("  • Attributed time: header parse time summed over the units including it")
+    print("")
+    print("OUTPUT FILES (in the output directory):")
+    print(f"  • {PROFILE_TEXT_NAME}: slowest units and most expensive headers with their includers")
+    print(f"  • {PROFILE_JSON_NAME}: the same data as JSON")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 compile_profile.py ../build-app-gpio_test-type-Debug-target-esp32c6-idf-release_v5_5")
+    print("  python3 compile_profile.py <build_tree> --top 50 --print all")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Compile-time attribution of the project's translation units",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_tree", nargs="?", help="Configured build tree")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--project-dir", help="Project directory")
+    parser.add_argument("--output-dir", help="Report directory")
+    parser.add_argument("--jobs", "-j", type=int, default=os.cpu_count() or 1, help="Concurrent compiler runs")
+    parser.add_argument("--top", type=int, default=DEFAULT_TOP, help="Rows in the report tables")
+    parser.add_argument("--max-headers", type=int, default=DEFAULT_MAX_HEADERS, help="Isolated header parses")
+    parser.add_argument("--print", dest="print_report", choices=["summary", "all", "none"], default="summary",
+                        help="Report to print")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_tree:
+        show_help()
+
+    return args
+
+def project_path_of(build_tree):
+    """Project directory recorded by ESP-IDF in project_description.json."""
+    try:
+        with open(build_tree / "project_description.json") as f:
+            return Path(json.load(f).get('project_path', ''))
+    except (OSError, ValueError):
+        return None
+
+def is_project_file(path, source_dirs, build_tree):
+    """True for files of the project's own and external components such as the wrapper library
+    (not ESP-IDF, managed components or generated files)."""
+    if path.is_relative_to(build_tree):
+        return False
+    for source_dir in source_dirs:
+        if path.is_relative_to(source_dir):
+            return not any(part in FOREIGN_DIRS for part in path.relative_to(source_dir).parts)
+    return False
+
+def front_end_command(entry):
+    """Compiler argv of a compile_commands.json entry without its outputs and source file."""
+    argv = entry.get('arguments') or shlex.split(entry['command'])
+    while argv and Path(argv[0]).name in LAUNCHERS:
+        argv = argv[1:]
+    source = Path(entry['directory'], entry['file']).resolve()
+    command = [argv[0]]
+    skip = False
+    for arg in argv[1:]:
+        if skip:
+            skip = False
+        elif arg in DROP_FLAGS_WITH_VALUE:
+            skip = True
+        elif arg in DROP_FLAGS or (arg.startswith("-o") and len(arg) > 2):
+            continue
+        elif not arg.startswith("-") and Path(entry['directory'], arg).resolve() == source:
+            continue
+        else:
+            command.append(arg)
+    return command
+
+def is_clang(command):
+    return "clang" in Path(command[0]).name
+
+def parse_include_trace(stderr, source):
+    """-H output -> (headers in include order, {header: includer}) for one unit."""
+    headers = {}
+    includers = {}
+    stack = [source]    # stack[d] = file at include depth d
+    for line in stderr.splitlines():
+        match = INCLUDE_TRACE_RE.match(line)
+        if not match:
+            continue
+        depth = len(match.group(1))
+        header = str(Path(match.group(2)).resolve())
+        del stack[depth:]
+        if len(stack) == depth:
+            includers.setdefault(header, stack[-1])
+            stack.append(header)
+        headers.setdefault(header)
+    return list(headers), includers
+
+def parse_time_report(stderr):
+    """GCC -ftime-report -> (parse ms, total ms), wall clock."""
+    parse_s = 0.0
+    total_s = None
+    for line in stderr.splitlines():
+        match = TIME_REPORT_RE.match(line)
+        if not match:
+            continue
+        name, wall = match.group(1), float(match.group(4))
+        if name in GCC_PARSE_PHASES:
+            parse_s += wall
+        elif name == "TOTAL":
+            total_s = wall
+    return round(parse_s * 1000, 1), None if total_s is None else round(total_s * 1000, 1)
+
+def parse_time_trace(trace_file):
+    """clang -ftime-trace -> (frontend ms, total ms, {header: parse ms})."""
+    try:
+        with open(trace_file) as f:
+            events = json.load(f).get('traceEvents', [])
+    except (OSError, ValueError):
+        return None, None, {}
+    header_ms = {}
+    frontend_ms = total_ms = None
+    for event in events:
+        name = event.get('name')
+        if name == "Source":
+            header = str(Path(event.get('args', {}).get('detail', '')).resolve())
+            header_ms[header] = header_ms.get(header, 0) + event.get('dur', 0) / 1000
+        elif name == "Total Frontend":
+            frontend_ms = event.get('dur', 0) / 1000
+        elif name == "Total ExecuteCompiler":
+            total_ms = event.get('dur', 0) / 1000
+    return frontend_ms, total_ms, header_ms
+
+def profile_unit(entry, trace_dir, index):
+    """Front-end run of one translation unit."""
+    source = str(Path(entry['directory'], entry['file']).resolve())
+    flags = front_end_command(entry)
+    command = flags + ["-fsyntax-only", "-H"]
+    trace_file = Path(trace_dir) / f"{index}.json"
+    if is_clang(command):
+        command += [f"-ftime-trace={trace_file}", "-ftime-trace-granularity=0"]
+    else:
+        command += ["-ftime-report"]
+    proc = subprocess.run(command + [source], cwd=entry['directory'],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True, errors="replace")
+
+    headers, includers = parse_include_trace(proc.stderr, source)
+    unit = {'file': source, 'exit_code': proc.returncode, 'headers': headers, 'includers': includers,
+            'flags': flags, 'directory': entry['directory']}
+    if is_clang(command):
+        unit['parse_ms'], unit['total_ms'], unit['header_ms'] = parse_time_trace(trace_file)
+    else:
+        unit['parse_ms'], unit['total_ms'] = parse_time_report(proc.stderr)
+    if proc.returncode != 0:
+        unit['error'] = proc.stderr.splitlines()[-5:]
+    return unit
+
+def profile_header(header, unit):
+    """Parse time of one header on its own, with the flags of a unit that includes it (GCC)."""
+    language = "c" if unit['file'].endswith(".c") else "c++"
+    proc = subprocess.run(unit['flags'] + ["-fsyntax-only", "-ftime-report", "-x", language, "-"],
+                          input=f'#include "{header}"\n', cwd=unit['directory'],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True, errors="replace")
+    if proc.returncode != 0:
+        return None
+    return parse_time_report(proc.stderr)[0]
+
+def attribute_headers(units, source_dirs, build_tree, jobs, max_headers):
+    """Per-header include statistics and attributed parse time."""
+    headers = {}
+    for unit in units:
+        for header in unit['headers']:
+            stats = headers.setdefault(header, {'units': [], 'includers': set(), 'unit_ms': []})
+            stats['units'].append(unit['file'])
+            stats['includers'].add(unit['includers'].get(header, unit['file']))
+            if 'header_ms' in unit and header in unit['header_ms']:
+                stats['unit_ms'].append(unit['header_ms'][header])
+
+    clang = any('header_ms' in unit for unit in units)
+    if not clang:
+        # Only headers a project file includes can be split, forward-declared or dropped
+        candidates = [h for h, stats in headers.items()
+                      if any(is_project_file(Path(i), source_dirs, build_tree) for i in stats['includers'])
+                      or is_project_file(Path(h), source_dirs, build_tree)]
+        candidates.sort(key=lambda h: -len(headers[h]['units']))
+        candidates = candidates[:max_headers]
+        first_unit = {unit['file']: unit for unit in units}
+        with ThreadPoolExecutor(max_workers=jobs) as pool:
+            parse_times = pool.map(lambda h: profile_header(h, first_unit[headers[h]['units'][0]]), candidates)
+            for header, parse_ms in zip(candidates, parse_times):
+                if parse_ms is not None:
+                    headers[header]['unit_ms'] = [parse_ms] * len(headers[header]['units'])
+
+    idf_path = Path(os.environ['IDF_PATH']).resolve() if os.environ.get('IDF_PATH') else None
+    report = []
+    for header, stats in headers.items():
+        if not stats['unit_ms']:
+            continue
+        path = Path(header)
+        if is_project_file(path, source_dirs, build_tree):
+            origin = 'project'
+        elif 'managed_components' in path.parts:
+            origin = 'managed'
+        elif idf_path and path.is_relative_to(idf_path):
+            origin = 'idf'
+        else:
+            origin = 'toolchain'
+        report.append({
+            'header': header,
+            'origin': origin,
+            'parse_ms': round(sum(stats['unit_ms']) / len(stats['unit_ms']), 1),
+            'attributed_ms': round(sum(stats['unit_ms']), 1),
+            'unit_count': len(stats['units']),
+            'units': sorted(stats['units']),
+            'included_by': sorted(stats['includers']),
+        })
+    report.sort(key=lambda h: -h['attributed_ms'])
+    return report, 'clang -ftime-trace' if clang else 'gcc -ftime-report (isolated header parse)'
+
+def display_path(path, project_dir):
+    try:
+        return str(Path(path).relative_to(project_dir))
+    except ValueError:
+        return path
+
+def format_summary(units, headers, method, project_dir, top):
+    """Text summary: totals and the most expensive headers."""
+    ok = [unit for unit in units if unit['exit_code'] == 0]
+    parse_total = sum(unit['parse_ms'] or 0 for unit in ok)
+    lines = [f"=== Compile Front End ({len(ok)}/{len(units)} units, {method}) ===",
+             f"Parse time of all units: {parse_total / 1000:.2f}s"]
+    lines.append("")
+    lines.append(f"=== Most Expensive Headers (top {top}, parse time x including units) ===")
+    lines.append(f"{'Attributed':>11}{'Parse':>10}{'Units':>7}  {'Origin':<11}Header")
+    for header in headers[:top]:
+        lines.append(f"{header['attributed_ms'] / 1000:>10.2f}s{header['parse_ms']:>8.0f}ms"
+                     f"{header['unit_count']:>7}  {header['origin']:<11}{display_path(header['header'], project_dir)}")
+        includers = [display_path(i, project_dir) for i in header['included_by']]
+        more = f" (+{len(includers) - 3})" if len(includers) > 3 else ""
+        lines.append(f"{'':>32}included by {', '.join(includers[:3])}{more}")
+    return "\n".join(lines) + "\n"
+
+def format_details(units, headers, project_dir, top):
+    """Text details: slowest units and the units behind each expensive header."""
+    lines = [f"=== Slowest Translation Units (top {top}, front end) ==="]
+    lines.append(f"{'Parse':>10}{'Total':>10}{'Headers':>9}  Unit")
+    for unit in sorted(units, key=lambda u: -(u['parse_ms'] or 0))[:top]:
+        total = "-" if unit['total_ms'] is None else f"{unit['total_ms']:.0f}ms"
+        status = "" if unit['exit_code'] == 0 else "  (failed)"
+        lines.append(f"{unit['parse_ms'] or 0:>8.0f}ms{total:>10}{len(unit['headers']):>9}  "
+                     f"{display_path(unit['file'], project_dir)}{status}")
+
+    lines.append("")
+    lines.append(f"=== Units Including the Most Expensive Headers (top {top}) ===")
+    for header in headers[:top]:
+        lines.append(f"{display_path(header['header'], project_dir)}:")
+        for unit in header['units']:
+            lines.append(f"    {display_path(unit, project_dir)}")
+    return "\n".join(lines) + "\n"
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    build_tree = Path(args.build_tree).resolve()
+    try:
+        with open(build_tree / "compile_commands.json") as f:
+            entries = json.load(f)
+    except (OSError, ValueError) as e:
+        print(f"Error: Cannot read compile_commands.json of {build_tree}: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    project_dir = Path(args.project_dir).resolve() if args.project_dir else project_path_of(build_tree)
+    if not project_dir:
+        print("Error: Project directory unknown, use --project-dir", file=sys.stderr)
+        sys.exit(1)
+    # main/, components/ and the external components (EXTRA_COMPONENT_DIRS) of the build
+    source_dirs = [path.resolve() for path in component_dirs(project_dir, load_project_description(build_tree))]
+    entries = [entry for entry in entries
+               if is_project_file(Path(entry['directory'], entry['file']).resolve(), source_dirs, build_tree)]
+    if not entries:
+        print(f"Error: No project translation units in {build_tree}/compile_commands.json", file=sys.stderr)
+        sys.exit(1)
+
+    with tempfile.TemporaryDirectory(prefix="compile_profile.") as trace_dir:
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            units = list(pool.map(lambda item: profile_unit(item[1], trace_dir, item[0]), enumerate(entries)))
+    headers, method = attribute_headers([u for u in units if u['exit_code'] == 0], source_dirs, build_tree,
+                                        args.jobs, args.max_headers)
+
+    text_summary = format_summary(units, headers, method, project_dir, args.top)
+    report = text_summary + "\n" + format_details(units, headers, project_dir, args.top)
+    output_dir = Path(args.output_dir) if args.output_dir else build_tree
+    try:
+        (output_dir / PROFILE_TEXT_NAME).write_text(report)
+        (output_dir / PROFILE_JSON_NAME).write_text(json.dumps({
+            'method': method,
+            'project_dir': str(project_dir),
+            'units': [{key: unit[key] for key in ('file', 'exit_code', 'parse_ms', 'total_ms', 'error')
+                       if key in unit} | {'header_count': len(unit['headers'])} for unit in units],
+            'headers': headers,
+        }, indent=2) + "\n")
+    except OSError as e:
+        print(f"Error writing compile profile: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if args.print_report == 'all':
+        sys.stdout.write(report)
+    elif args.print_report == 'summary':
+        sys.stdout.write(text_summary)
+
+    if any(unit['exit_code'] != 0 for unit in units):
+        print("WARNING: Some units failed to parse, see compile_profile.json", file=sys.stderr)
+
+if __name__ == '__main__':
+    main()
@@ -3,14 +3,15 @@
 # ===============================
 # This script provides enhanced configuration functions for ESP32 applications
 # with support for app-specific overrides, version-aware validation, and
-# robust fallback parsing for CI pipeline compatibility.
+# a compiled snapshot produced by the shared Python resolver (config_resolver.py).
 #
 # KEY FEATURES:
 # • App-specific build type and IDF version overrides
 # • Version-aware build type validation
 # • Smart fallback to metadata defaults
 # • Comprehensive combination validation
-# • Both yq and grep/sed fallback parsing
+# • Compiled config snapshot (resolved once, in-process lookups afterwards)
+# • yq queries when the snapshot is unavailable (no grep/sed YAML parsing)
 # • CI pipeline optimized functions
 #
 # USAGE: source ./config_loader.sh
@@ -37,6 +38,7 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
   echo "  # Configuration initialization"
   echo "  init_config               - Initialize configuration from app_config.yml"
   echo "  load_config                - Load configuration and set environment variables"
+  echo "  config_query              - Resolve many keys for an app/build type context in one call"
   echo ""
   echo "  # App information functions"
   echo "  get_app_types             - Get all valid app types"
@@ -51,6 +53,10 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
   echo "  is_valid_build_type       - Check if build type is valid (with app/IDF version support)"
   echo "  get_build_directory       - Get build directory for app/build type/target/idf_version"
   echo "  get_project_name          - Get project name for app type"
+  echo "  get_build_type_config_value - Get a build_config.build_types setting of a build type"
+  echo "  get_flash_config_value    - Get a flash_config setting (retry_attempts, retry_delay, ...)"
+  echo "  get_app_flash_config_value - Get an app's flash_config setting (baud_rate, flash_mode, ...)"
+  echo "  get_app_monitor_config_value - Get an app's monitor_config setting (baud_rate, ...)"
   echo ""
   echo "  # ESP-IDF and target functions"
   echo "  get_target                - Get target from config (with per-app override)"
@@ -85,6 +91,10 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
   echo "  build_dir=\$(get_build_directory \"gpio_test\" \"Release\" \"esp32c6\" \"release/v5.5\")"
   echo "  project_name=\$(get_project_name \"gpio_test\")"
   echo ""
+  echo "  # Batch query (one call, shell-safe KEY=value lines)"
+  echo "  eval \"\$(config_query --app gpio_test --build-type Release description build_dir project_name)\""
+  echo "  echo \"\$DESCRIPTION -> \$BUILD_DIR/\$PROJECT_NAME.bin\""
+  echo ""
   echo "  # Validate combinations"
   echo "  if is_valid_combination \"gpio_test\" \"Release\" \"release/v5.5\"; then"
   echo "    echo \"Valid combination\""
@@ -116,12 +126,19 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
   echo "  • CONFIG_DEFAULT_BUILD_TYPE: Default build configuration"
   echo "  • CONFIG_DEFAULT_IDF_VERSION: Default ESP-IDF version"
   echo "  • CONFIG_TARGET: Target MCU architecture"
+  echo "  • CONFIG_SNAPSHOT: Set to 0 to bypass the compiled config snapshot"
+  echo "  • IDF_SERVER: Set to 1 to run idf.py commands through idf_server.py (run_idf_py)"
+  echo ""
+  echo "CONFIGURATION SNAPSHOT:"
+  echo "  • app_config.yml is compiled once by config_snapshot.py into .app_config.snapshot.sh/.json"
+  echo "  • Snapshots are keyed on the config file mtime and SHA-256 content hash"
+  echo "  • All query functions become in-process lookups once the snapshot is loaded"
   echo ""
   echo "FUNCTION SAFETY:"
   echo "  • All functions are standalone-safe"
   echo "  • Can be sourced independently"
   echo "  • Error handling for missing configuration"
-  echo "  • Fallback values for missing data"
+  echo "  • Clear error when neither the snapshot nor yq can read the config"
   echo ""
   echo "ENHANCED FUNCTIONALITY:"
   echo "  • App-specific overrides for build types and IDF versions"
@@ -169,18 +186,147 @@ else
     CONFIG_FILE="$PROJECT_DIR/app_config.yml"
 fi
 
+# =============================================================================
+# COMPILED CONFIGURATION SNAPSHOT
+# =============================================================================
+# app_config.yml is resolved once by config_snapshot.py into a sourceable snapshot
+# of pre-resolved associative arrays (plus a JSON twin) stored next to the config
+# file. The snapshot is keyed on the config's mtime and SHA-256 content hash, so
+# every query below becomes an in-process lookup instead of a yq fork.
+# Set CONFIG_SNAPSHOT=0 to disable the snapshot and query the YAML directly.
+
+CONFIG_SNAPSHOT_FILE="$(dirname "$CONFIG_FILE")/.app_config.snapshot.sh"
+CONFIG_SNAPSHOT_FORMAT=7  # Must match SNAPSHOT_FORMAT in config_snapshot.py
+
+# Print "<mtime seconds> <ctime seconds> <signature>" for each existing file, one line per file.
+# The signature (size, inode, full-resolution mtime and ctime) changes on every write, including
+# copies and checkouts that keep the mtime: the ctime cannot be set back.
+config_file_stat() {
+    stat -c '%Y %Z %s:%i:%y:%z' "$@" 2>/dev/null || stat -f '%m %c %z:%i:%Fm:%Fc' "$@" 2>/dev/null
+}
+
+# Get SHA-256 content hash of a file
+config_file_hash() {
+    local hash_output
+    if command -v sha256sum &> /dev/null; then
+        hash_output=$(sha256sum "$1" 2>/dev/null) || return 1
+    else
+        hash_output=$(shasum -a 256 "$1" 2>/dev/null) || return 1
+    fi
+    echo "${hash_output%% *}"
+}
+
+# Check if a list returned by the query functions contains an item
+# Snapshot lists are clean space-separated words and are matched in-process;
+# raw yq/grep output keeps the historical word-boundary grep match
+config_list_contains() {
+    local list="$1"
+    local item="$2"
+    if config_snapshot_ready; then
+        [[ -n "$item" && " $list " == *" $item "* ]]
+    else
+        echo "$list" | grep -q "\b$item\b"
+    fi
+}
+
+# Check if the snapshot is usable (needs bash 4.2+ for global associative arrays)
+config_snapshot_enabled() {
+    [[ "${CONFIG_SNAPSHOT:-1}" != "0" ]] || return 1
+    (( BASH_VERSINFO[0] > 4 || (BASH_VERSINFO[0] == 4 && BASH_VERSINFO[1] >= 2) ))
+}
+
+# Check if a snapshot for the current config file is loaded in this shell
+config_snapshot_ready() {
+    [[ -n "$CFG_SNAPSHOT_LOADED" && "$CFG_SNAPSHOT_LOADED" == "$CONFIG_FILE" ]]
+}
+
+# Read the recorded stat signature and hash from a snapshot header without sourcing it
+read_config_snapshot_header() {
+    local snapshot="$1"
+    SNAPSHOT_HEADER_STAT=""
+    SNAPSHOT_HEADER_HASH=""
+    local line
+    while IFS= read -r line; do
+        case "$line" in
+            CFG_SNAPSHOT_FORMAT=*) [[ "${line#*=}" == "$CONFIG_SNAPSHOT_FORMAT" ]] || return 1 ;;
+            CFG_SNAPSHOT_STAT=*) SNAPSHOT_HEADER_STAT="${line#*=}" ;;
+            CFG_SNAPSHOT_HASH=*) SNAPSHOT_HEADER_HASH="${line#*=}" ;;
+            declare*) break ;;
+        esac
+    done < "$snapshot"
+    [[ -n "$SNAPSHOT_HEADER_STAT" && -n "$SNAPSHOT_HEADER_HASH" ]]
+}
+
+# Compile (if stale) and source the configuration snapshot
+# Returns: 0 if the snapshot is loaded, 1 to fall back to direct YAML parsing
+load_config_snapshot() {
+    config_snapshot_enabled || return 1
+    config_snapshot_ready && return 0
+
+    # One stat for both files: the config file's signature and the time the snapshot was written
+    local files=("$CONFIG_FILE") stat_output
+    [[ -f "$CONFIG_SNAPSHOT_FILE" ]] && files+=("$CONFIG_SNAPSHOT_FILE")
+    stat_output=$(config_file_stat "${files[@]}") || return 1
+    local config_ctime signature snapshot_mtime=0 _
+    {
+        read -r _ config_ctime signature
+        read -r snapshot_mtime _
+    } <<< "$stat_output"
+    signature="${signature// /_}"
+    [[ -n "$signature" ]] || return 1
+
+    local fresh=false
+    if [[ -f "$CONFIG_SNAPSHOT_FILE" ]] && read_config_snapshot_header "$CONFIG_SNAPSHOT_FILE"; then
+        # An edit in the second the snapshot was written can keep a coarse timestamp: check the hash
+        if [[ "$SNAPSHOT_HEADER_STAT" == "$signature" ]] && (( config_ctime < snapshot_mtime )); then
+            fresh=true
+        elif [[ "$SNAPSHOT_HEADER_HASH" == "$(config_file_hash "$CONFIG_FILE")" ]]; then
+            # Content unchanged (touch, checkout, copy) - only refresh the recorded signature
+            local content
+            content=$(<"$CONFIG_SNAPSHOT_FILE")
+            if printf '%s\n' "${content/CFG_SNAPSHOT_STAT=$SNAPSHOT_HEADER_STAT/CFG_SNAPSHOT_STAT=$signature}" > "$CONFIG_SNAPSHOT_FILE.$$" 2>/dev/null; then
+                mv -f "$CONFIG_SNAPSHOT_FILE.$$" "$CONFIG_SNAPSHOT_FILE" 2>/dev/null || rm -f "$CONFIG_SNAPSHOT_FILE.$$"
+            fi
+            fresh=true
+        fi
+    fi
+
+    if [[ "$fresh" != "true" ]]; then
+        command -v python3 &> /dev/null || return 1
+        if ! python3 "$SCRIPT_DIR/config_snapshot.py" "$CONFIG_FILE" --stat "$signature" 2>/dev/null; then
+            # Config directory not writable - compile into memory for this shell only
+            local snapshot_content
+            snapshot_content=$(python3 "$SCRIPT_DIR/config_snapshot.py" "$CONFIG_FILE" --stdout 2>/dev/null) || return 1
+            eval "$snapshot_content" || return 1
+            CFG_SNAPSHOT_LOADED="$CONFIG_FILE"
+            return 0
+        fi
+    fi
+
+    source "$CONFIG_SNAPSHOT_FILE" || return 1
+    CFG_SNAPSHOT_LOADED="$CONFIG_FILE"
+    return 0
+}
+
 # Check if yq is available for YAML parsing and detect version
 check_yq() {
-    # Always check for yq availability (no caching) - this allows detecting newly installed yq
+    # Always check for yq availability - command -v is a builtin, so this still
+    # detects newly installed yq without forking
     if ! command -v yq &> /dev/null; then
         # Only show warning if we haven't shown it in this script execution
         if [[ -z "$YQ_WARNING_SHOWN" ]]; then
-            echo "Warning: yq not found. Falling back to basic parsing." >&2
+            echo "Warning: yq not found. Configuration queries require the config snapshot (python3 + PyYAML)." >&2
             export YQ_WARNING_SHOWN=1
         fi
         return 1
     fi
-    
+
+    # Version detection forks yq, so only do it once per shell
+    if [[ -n "$YQ_SYNTAX_DETECTED" ]]; then
+        return 0
+    fi
+    YQ_SYNTAX_DETECTED=1
+
     # Detect yq version and set appropriate syntax
     local yq_version=$(yq --version 2>/dev/null | grep -oE '[0-9]+\.[0-9]+' | head -1)
     if [[ -n "$yq_version" ]]; then
@@ -239,26 +385,26 @@ load_config_yq() {
     return 0
 }
 
-# Fallback: Basic parsing without yq
-load_config_basic() {
-    # Extract basic configuration using grep and sed (cleaner quote handling)
-    export CONFIG_DEFAULT_APP=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "default_app:" | sed 's/.*default_app: *"*\([^"]*\)"*.*/\1/')
-    export CONFIG_DEFAULT_BUILD_TYPE=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "default_build_type:" | sed 's/.*default_build_type: *"*\([^"]*\)"*.*/\1/')
-    export CONFIG_TARGET=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "target:" | sed 's/.*target: *"*\([^"]*\)"*.*/\1/')
-    
-    # Extract default ESP-IDF version
-    export CONFIG_DEFAULT_IDF_VERSION=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "idf_versions:" | sed 's/.*idf_versions: *\[*"*\([^"]*\)"*.*/\1/' | head -1 || echo "release/v5.5")
-    
+# Load configuration from the compiled snapshot (preferred method)
+load_config_from_snapshot() {
+    if ! load_config_snapshot; then
+        return 1
+    fi
+
+    export CONFIG_DEFAULT_APP="${CFG_META[default_app]}"
+    export CONFIG_DEFAULT_BUILD_TYPE="${CFG_META[default_build_type]}"
+    export CONFIG_TARGET="${CFG_META[target]}"
+    export CONFIG_DEFAULT_IDF_VERSION="${CFG_META[default_idf_version]}"
+
     return 0
 }
 
 # Get list of valid app types
 get_app_types() {
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_APP_LIST[*]}"
+    elif check_yq; then
         run_yq '.apps | keys | .[]' -r | tr '\n' ' '
-    else
-        # Fallback: extract from apps section (use more specific range)
-        sed -n '/^apps:/,/^build_config:/p' "$CONFIG_FILE" | grep '^  [a-zA-Z0-9_]*:$' | sed 's/^  \(.*\):$/\1/' | sort | tr '\n' ' '
     fi
 }
 
@@ -269,46 +415,31 @@ get_app_types() {
 get_build_types() {
     local app_type="${1:-}"
     
+    if config_snapshot_ready; then
+        if [[ -n "$app_type" && -n "${CFG_APP_BUILD_TYPES[$app_type]+set}" ]]; then
+            echo "${CFG_APP_BUILD_TYPES[$app_type]}"
+        else
+            echo "${CFG_META[build_types]}"
+        fi
+        return 0
+    fi
+    
     # If app type is specified, check for app-specific overrides first
     if [[ -n "$app_type" ]]; then
         if check_yq; then
-            local app_build_types=$(run_yq ".apps.$app_type.build_types | .[]" -r 2>/dev/null | tr '\n' ' ')
+            # Flatten nested per-IDF-version lists, keeping first-seen order
+            local app_build_types=$(run_yq ".apps.$app_type.build_types | flatten | .[]" -r 2>/dev/null | awk '!seen[$0]++' | tr '\n' ' ')
             if [[ -n "$app_build_types" && "$app_build_types" != "null" ]]; then
                 # App has specific build types, return them
                 echo "$app_build_types"
                 return 0
             fi
-        else
-            # Fallback: extract from apps section
-            local build_line=$(sed -n "/^  $app_type:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "build_types:")
-            if [[ -n "$build_line" ]]; then
-                # Extract all build types from array, handling quotes and commas
-                local app_build_types=$(echo "$build_line" | sed 's/.*build_types: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g' | tr '\n' ' ' | sed 's/^ *//' | sed 's/ *$//')
-                if [[ -n "$app_build_types" ]]; then
-                    echo "$app_build_types"
-                    return 0
-                fi
-            fi
         fi
     fi
     
     # Fall back to metadata defaults (flattened for backward compatibility)
     if check_yq; then
         run_yq '.metadata.build_types | .[] | .[]' -r 2>/dev/null | sort -u | tr '\n' ' '
-    else
-        # Fallback: extract from metadata section
-        local build_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "build_types:")
-        if [[ -n "$build_line" ]]; then
-            # Extract all build types from nested array, handling quotes and commas
-            # Format: [["Debug", "Release"], ["Debug"]] -> Debug Release
-            # First, extract the content between the outer brackets
-            local content=$(echo "$build_line" | sed 's/.*build_types: *\[//' | sed 's/\].*//')
-            # Then extract individual build types, handling nested arrays
-            echo "$content" | sed 's/\[//g' | sed 's/\]//g' | sed 's/"//g' | sed 's/,/ /g' | sed 's/  */ /g' | sed 's/^ *//' | sed 's/ *$//' | tr ' ' '\n' | sort -u | tr '\n' ' '
-        else
-            echo "ERROR: Could not extract build types from config" >&2
-            return 1
-        fi
     fi
 }
 
@@ -316,7 +447,14 @@ get_build_types() {
 get_build_types_for_idf_version() {
     local idf_version="$1"
     
-    if check_yq; then
+    if config_snapshot_ready; then
+        if [[ -n "${CFG_IDF_BUILD_TYPES[$idf_version]+set}" ]]; then
+            echo "${CFG_IDF_BUILD_TYPES[$idf_version]}"
+        else
+            echo "ERROR: IDF version $idf_version not found in metadata" >&2
+            return 1
+        fi
+    elif check_yq; then
         # Get the index of the IDF version
         local version_index=$(run_yq ".metadata.idf_versions | index(\"$idf_version\")" -r 2>/dev/null)
         if [[ -n "$version_index" && "$version_index" != "null" ]]; then
@@ -326,51 +464,6 @@ get_build_types_for_idf_version() {
             echo "ERROR: IDF version $idf_version not found in metadata" >&2
             return 1
         fi
-    else
-        # Fallback: extract using grep and sed
-        local idf_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-        local build_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "build_types:")
-        
-        if [[ -n "$idf_line" && -n "$build_line" ]]; then
-            # Extract IDF versions array
-            local idf_content=$(echo "$idf_line" | sed 's/.*idf_versions: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g')
-            
-            # Find the index of the requested IDF version
-            local index=0
-            local found=false
-            while IFS= read -r version; do
-                if [[ "$version" == "$idf_version" ]]; then
-                    found=true
-                    break
-                fi
-                ((index++))
-            done < <(echo "$idf_content" | tr ' ' '\n')
-            
-            if [[ "$found" == "true" ]]; then
-                # Extract build types for that specific index
-                local build_content=$(echo "$build_line" | sed 's/.*build_types: *\[//' | sed 's/\].*//')
-                
-                # Split by '], [' to get individual arrays
-                local arrays=()
-                IFS='], [' read -ra arrays <<< "$build_content"
-                
-                # Get the array at the specified index
-                if [[ $index -lt ${#arrays[@]} ]]; then
-                    local target_array="${arrays[$index]}"
-                    # Clean up the array content
-                    echo "$target_array" | sed 's/"//g' | sed 's/,/ /g' | sed 's/^ *//' | sed 's/ *$//'
-                else
-                    echo "ERROR: Build types index $index not found" >&2
-                    return 1
-                fi
-            else
-                echo "ERROR: IDF version $idf_version not found" >&2
-                return 1
-            fi
-        else
-            echo "ERROR: Could not extract IDF versions or build types from config" >&2
-            return 1
-        fi
     fi
 }
 
@@ -382,25 +475,15 @@ get_build_types_for_idf_version() {
 get_idf_version_index() {
     local idf_version="$1"
     
-    if check_yq; then
-        run_yq ".metadata.idf_versions | index(\"$idf_version\")" -r 2>/dev/null
-    else
-        # Fallback: extract using grep and find index
-        local idf_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-        if [[ -n "$idf_line" ]]; then
-            local idf_content=$(echo "$idf_line" | sed 's/.*idf_versions: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g')
-            
-            local index=0
-            while IFS= read -r version; do
-                if [[ "$version" == "$idf_version" ]]; then
-                    echo "$index"
-                    return 0
-                fi
-                ((index++))
-            done < <(echo "$idf_content" | tr ' ' '\n')
+    if config_snapshot_ready; then
+        if [[ -n "${CFG_IDF_VERSION_INDEX[$idf_version]+set}" ]]; then
+            echo "${CFG_IDF_VERSION_INDEX[$idf_version]}"
+        else
+            echo "ERROR: IDF version $idf_version not found" >&2
+            return 1
         fi
-        echo "ERROR: IDF version $idf_version not found" >&2
-        return 1
+    elif check_yq; then
+        run_yq ".metadata.idf_versions | index(\"$idf_version\")" -r 2>/dev/null
     fi
 }
 
@@ -414,7 +497,19 @@ get_app_build_types_for_idf_version() {
     local app_type="$1"
     local idf_version="$2"
     
-    if check_yq; then
+    if config_snapshot_ready; then
+        if [[ -n "${CFG_APP_IDF_BUILD_TYPES[$app_type|$idf_version]+set}" ]]; then
+            echo "${CFG_APP_IDF_BUILD_TYPES[$app_type|$idf_version]}"
+            return 0
+        fi
+        # Fall back to global metadata for this IDF version
+        if [[ -n "${CFG_IDF_BUILD_TYPES[$idf_version]+set}" ]]; then
+            echo "${CFG_IDF_BUILD_TYPES[$idf_version]}"
+            return 0
+        fi
+        echo "ERROR: Could not determine build types for $app_type with $idf_version" >&2
+        return 1
+    elif check_yq; then
         # Check if app has specific build types
         local app_build_types=$(run_yq ".apps.$app_type.build_types" -r 2>/dev/null)
         if [[ -n "$app_build_types" && "$app_build_types" != "null" ]]; then
@@ -450,79 +545,6 @@ get_app_build_types_for_idf_version() {
             return 0
         fi
         
-        echo "ERROR: Could not determine build types for $app_type with $idf_version" >&2
-        return 1
-    else
-        # Fallback: extract using grep and sed
-        local app_idf_versions=$(sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "idf_versions:")
-        local app_build_types=$(sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "build_types:")
-        
-        if [[ -n "$app_build_types" ]]; then
-            # App has specific build types
-            if [[ "$app_build_types" =~ \[.*\[.*\].*\] ]]; then
-                # Nested format detected
-                if [[ -n "$app_idf_versions" ]]; then
-                    # Find index of this IDF version in app's IDF versions
-                    local app_idf_content=$(echo "$app_idf_versions" | sed 's/.*idf_versions: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g')
-                    local index=0
-                    local found=false
-                    while IFS= read -r version; do
-                        if [[ "$version" == "$idf_version" ]]; then
-                            found=true
-                            break
-                        fi
-                        ((index++))
-                    done < <(echo "$app_idf_content" | tr ' ' '\n')
-                    
-                    if [[ "$found" == "true" ]]; then
-                        # Extract build types for that specific index
-                        local build_content=$(echo "$app_build_types" | sed 's/.*build_types: *\[//' | sed 's/\].*//')
-                        local arrays=()
-                        IFS='], [' read -ra arrays <<< "$build_content"
-                        
-                        if [[ $index -lt ${#arrays[@]} ]]; then
-                            local target_array="${arrays[$index]}"
-                            echo "$target_array" | sed 's/"//g' | sed 's/,/ /g' | sed 's/^ *//' | sed 's/ *$//'
-                            return 0
-                        fi
-                    fi
-                fi
-            else
-                # Flat format: extract directly
-                echo "$app_build_types" | sed 's/.*build_types: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g' | sed 's/^ *//' | sed 's/ *$//'
-                return 0
-            fi
-        fi
-        
-        # Fall back to global metadata for this IDF version
-        local global_idf_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-        local global_build_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "build_types:")
-        
-        if [[ -n "$global_idf_line" && -n "$global_build_line" ]]; then
-            local global_idf_content=$(echo "$global_idf_line" | sed 's/.*idf_versions: *\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g')
-            local index=0
-            local found=false
-            while IFS= read -r version; do
-                if [[ "$version" == "$idf_version" ]]; then
-                    found=true
-                    break
-                fi
-                ((index++))
-            done < <(echo "$global_idf_content" | tr ' ' '\n')
-            
-            if [[ "$found" == "true" ]]; then
-                local build_content=$(echo "$global_build_line" | sed 's/.*build_types: *\[//' | sed 's/\].*//')
-                local arrays=()
-                IFS='], [' read -ra arrays <<< "$build_content"
-                
-                if [[ $index -lt ${#arrays[@]} ]]; then
-                    local target_array="${arrays[$index]}"
-                    echo "$target_array" | sed 's/"//g' | sed 's/,/ /g' | sed 's/^ *//' | sed 's/ *$//'
-                    return 0
-                fi
-            fi
-        fi
-        
         echo "ERROR: Could not determine build types for $app_type with $idf_version" >&2
         return 1
     fi
@@ -530,36 +552,10 @@ get_app_build_types_for_idf_version() {
 
 # Get list of available ESP-IDF versions
 get_idf_versions() {
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_IDF_VERSION_LIST[*]}"
+    elif check_yq; then
         run_yq '.metadata.idf_versions | .[]' -r 2>/dev/null | tr '\n' ' '
-    else
-        # Fallback: extract from metadata section
-        local idf_line=$(grep -A 10 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-        if [[ -n "$idf_line" ]]; then
-            # Extract all versions from array, handling quotes and commas
-            echo "$idf_line" | sed 's/.*\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g' | tr '\n' ' '
-        else
-            echo "ERROR: Could not extract IDF versions from config" >&2
-            return 1
-        fi
-    fi
-}
-
-# Get app-specific ESP-IDF versions
-get_app_idf_versions() {
-    local app_type="$1"
-    if check_yq; then
-        run_yq ".apps.$app_type.idf_versions | .[]" -r 2>/dev/null | tr '\n' ' '
-    else
-        # Fallback: extract from apps section
-                    local idf_line=$(sed -n "/^  $app_type:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "idf_versions:")
-        if [[ -n "$idf_line" ]]; then
-            # Extract all versions from array, handling quotes and commas
-            echo "$idf_line" | sed 's/.*\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g' | tr '\n' ' '
-        else
-            echo "ERROR: Could not extract app IDF versions from config" >&2
-            return 1
-        fi
     fi
 }
 
@@ -572,28 +568,30 @@ get_app_idf_versions() {
 # Get description for an app type
 get_app_description() {
     local app_type="$1"
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_APP_DESCRIPTION[$app_type]}"
+    elif check_yq; then
         run_yq ".apps.${app_type}.description" -r
-    else
-        # Fallback: extract description using grep (improved regex)
-        sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "description:" | sed 's/.*description: *["\x27]*\([^"\x27]*\)["\x27]*.*/\1/' | head -1
     fi
 }
 
 # Get source file for an app type
 get_app_source_file() {
     local app_type="$1"
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_APP_SOURCE_FILE[$app_type]}"
+    elif check_yq; then
         run_yq ".apps.${app_type}.source_file" -r
-    else
-        # Fallback: extract source_file using grep
-        sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "source_file:" | sed 's/.*source_file: *"\(.*\)".*/\1/'
     fi
 }
 
 # Check if app type is valid
 is_valid_app_type() {
     local app_type="$1"
+    if config_snapshot_ready; then
+        [[ -n "$app_type" && -n "${CFG_APP_TARGET[$app_type]+set}" ]]
+        return
+    fi
     local valid_types=$(get_app_types)
     echo "$valid_types" | grep -q "\b$app_type\b"
 }
@@ -613,7 +611,7 @@ is_valid_build_type() {
     if [[ -n "$app_type" && -n "$idf_version" ]]; then
         local app_version_build_types=$(get_app_build_types_for_idf_version "$app_type" "$idf_version")
         if [[ -n "$app_version_build_types" ]]; then
-            if echo "$app_version_build_types" | grep -q "\b$build_type\b"; then
+            if config_list_contains "$app_version_build_types" "$build_type"; then
                 return 0  # Valid for this app and IDF version
             fi
         fi
@@ -623,7 +621,7 @@ is_valid_build_type() {
     if [[ -n "$app_type" ]]; then
         local app_build_types=$(get_build_types "$app_type")
         if [[ -n "$app_build_types" ]]; then
-            if echo "$app_build_types" | grep -q "\b$build_type\b"; then
+            if config_list_contains "$app_build_types" "$build_type"; then
                 return 0  # Valid for this app
             fi
         fi
@@ -633,7 +631,7 @@ is_valid_build_type() {
     if [[ -n "$idf_version" ]]; then
         local version_build_types=$(get_build_types_for_idf_version "$idf_version")
         if [[ -n "$version_build_types" ]]; then
-            if echo "$version_build_types" | grep -q "\b$build_type\b"; then
+            if config_list_contains "$version_build_types" "$build_type"; then
                 return 0  # Valid for this IDF version
             fi
         fi
@@ -641,61 +639,188 @@ is_valid_build_type() {
     
     # Fall back to global build types (for backward compatibility)
     local valid_types=$(get_build_types)
-    echo "$valid_types" | grep -q "\b$build_type\b"
+    config_list_contains "$valid_types" "$build_type"
 }
 
-# Get build directory pattern
-get_build_directory() {
-    local app_type="$1"
-    local build_type="$2"
-    local target="${3:-$(get_target)}"
-    local idf_version="${4:-$(get_idf_version)}"
+# Expand the build directory pattern into a variable without a subshell
+# Usage: config_expand_build_directory out_var app_type build_type target idf_version
+config_expand_build_directory() {
+    local out_var="$1"
+    local app_type="$2"
+    local build_type="$3"
+    local target="$4"
+    local idf_version="$5"
     
     # Sanitize IDF version for directory names (replace / and . with _)
-    local sanitized_idf_version=$(echo "$idf_version" | sed 's/[\/\.]/_/g')
+    local sanitized_idf_version="${idf_version//[\/.]/_}"
     
     # Get the build directory name pattern
     local build_dir_name
-    if check_yq; then
-        local pattern=$(run_yq '.build_config.build_directory_pattern' -r)
-        build_dir_name=$(echo "${pattern}" | sed "s/{app_type}/${app_type}/g" | sed "s/{build_type}/${build_type}/g" | sed "s/{target}/${target}/g" | sed "s/{idf_version}/${sanitized_idf_version}/g")
+    local pattern=""
+    if config_snapshot_ready; then
+        pattern="${CFG_META[build_directory_pattern]}"
+    elif check_yq; then
+        pattern=$(run_yq '.build_config.build_directory_pattern' -r)
+    fi
+    if [[ -n "$pattern" && "$pattern" != "null" ]]; then
+        build_dir_name="${pattern//\{app_type\}/$app_type}"
+        build_dir_name="${build_dir_name//\{build_type\}/$build_type}"
+        build_dir_name="${build_dir_name//\{target\}/$target}"
+        build_dir_name="${build_dir_name//\{idf_version\}/$sanitized_idf_version}"
     else
         # Fallback pattern with hyphens and prefixes
         build_dir_name="build-app-${app_type}-type-${build_type}-target-${target}-idf-${sanitized_idf_version}"
     fi
     
     # Always return absolute path relative to project directory
-    echo "$PROJECT_DIR/$build_dir_name"
+    printf -v "$out_var" '%s' "$PROJECT_DIR/$build_dir_name"
+}
+
+# Get build directory pattern
+get_build_directory() {
+    local app_type="$1"
+    local build_type="$2"
+    local target="${3:-$(get_target)}"
+    local idf_version="${4:-$(get_idf_version)}"
+    
+    local build_dir
+    config_expand_build_directory build_dir "$app_type" "$build_type" "$target" "$idf_version"
+    echo "$build_dir"
+}
+
+# Expand the project name pattern into a variable without a subshell
+# Usage: config_expand_project_name out_var app_type
+config_expand_project_name() {
+    local out_var="$1"
+    local app_type="$2"
+    local pattern=""
+    if config_snapshot_ready; then
+        pattern="${CFG_META[project_name_pattern]}"
+    elif check_yq; then
+        pattern=$(run_yq '.build_config.project_name_pattern' -r)
+    fi
+    if [[ -n "$pattern" && "$pattern" != "null" ]]; then
+        printf -v "$out_var" '%s' "${pattern//\{app_type\}/$app_type}"
+    else
+        printf -v "$out_var" '%s' "esp32_iid_${app_type}_app"
+    fi
 }
 
 # Get project name pattern
 get_project_name() {
+    local project_name
+    config_expand_project_name project_name "$1"
+    echo "$project_name"
+}
+
+# Get a scalar build_config value (parallel_builds, cpu_limit, memory_limit, ...)
+# Usage: get_build_config_value key [default]
+get_build_config_value() {
+    local key="$1"
+    local default="$2"
+    local value=""
+    if config_snapshot_ready; then
+        value="${CFG_BUILD_CONFIG[$key]}"
+    elif check_yq; then
+        value=$(run_yq ".build_config.$key" -r)
+    fi
+    if [[ -z "$value" || "$value" == "null" ]]; then
+        value="$default"
+    fi
+    echo "$value"
+}
+
+# Get a scalar setting of a build type from build_config.build_types (cmake_build_type,
+# unity_build, unity_batch_size, ...)
+# Usage: get_build_type_config_value build_type key [default]
+get_build_type_config_value() {
+    local build_type="$1"
+    local key="$2"
+    local default="$3"
+    local value=""
+    if config_snapshot_ready; then
+        value="${CFG_BUILD_TYPE_CONFIG[$build_type|$key]}"
+    elif check_yq; then
+        value=$(run_yq ".build_config.build_types.\"$build_type\".$key" -r)
+    fi
+    if [[ -z "$value" || "$value" == "null" ]]; then
+        value="$default"
+    fi
+    echo "$value"
+}
+
+# Get a scalar flash_config value (retry_attempts, retry_delay, flash_timeout, ...)
+# Usage: get_flash_config_value key [default]
+get_flash_config_value() {
+    local key="$1"
+    local default="$2"
+    local value=""
+    if config_snapshot_ready; then
+        value="${CFG_FLASH_CONFIG[$key]}"
+    elif check_yq; then
+        value=$(run_yq ".flash_config.$key" -r)
+    fi
+    if [[ -z "$value" || "$value" == "null" ]]; then
+        value="$default"
+    fi
+    echo "$value"
+}
+
+# Get a flash_config value of an app (baud_rate, flash_mode, flash_freq, flash_size, ...);
+# the app's own flash_config overrides the global one
+# Usage: get_app_flash_config_value app_type key [default]
+get_app_flash_config_value() {
     local app_type="$1"
-    if check_yq; then
-        local pattern=$(run_yq '.build_config.project_name_pattern' -r)
-        echo "${pattern}" | sed "s/{app_type}/${app_type}/g"
-    else
-        echo "esp32_iid_${app_type}_app"
+    local key="$2"
+    local default="$3"
+    local value=""
+    if config_snapshot_ready; then
+        value="${CFG_APP_FLASH_CONFIG[$app_type|$key]}"
+        if [[ -z "$value" ]]; then
+            value="${CFG_FLASH_CONFIG[$key]}"
+        fi
+    elif check_yq; then
+        value=$(run_yq ".apps.\"$app_type\".flash_config.$key // .flash_config.$key" -r)
+    fi
+    if [[ -z "$value" || "$value" == "null" ]]; then
+        value="$default"
     fi
+    echo "$value"
+}
+
+# Get a monitor_config value of an app (baud_rate, ...)
+# Usage: get_app_monitor_config_value app_type key [default]
+get_app_monitor_config_value() {
+    local app_type="$1"
+    local key="$2"
+    local default="$3"
+    local value=""
+    if config_snapshot_ready; then
+        value="${CFG_APP_MONITOR_CONFIG[$app_type|$key]}"
+    elif check_yq; then
+        value=$(run_yq ".apps.\"$app_type\".monitor_config.$key" -r)
+    fi
+    if [[ -z "$value" || "$value" == "null" ]]; then
+        value="$default"
+    fi
+    echo "$value"
 }
 
 # Get CI-enabled app types
 get_ci_app_types() {
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_CI_APP_LIST[*]}"
+    elif check_yq; then
         run_yq '.apps | to_entries | map(select(.value.ci_enabled == true)) | .[].key' -r | tr '\n' ' '
-    else
-        # Fallback: return all app types
-        get_app_types
     fi
 }
 
 # Get featured app types
 get_featured_app_types() {
-    if check_yq; then
+    if config_snapshot_ready; then
+        echo "${CFG_FEATURED_APP_LIST[*]}"
+    elif check_yq; then
         run_yq '.apps | to_entries | map(select(.value.featured == true)) | .[].key' -r | tr '\n' ' '
-    else
-        # Fallback: return default featured apps
-        echo "ascii_art gpio_test adc_test pio_test bluetooth_test utils_test "
     fi
 }
 
@@ -703,6 +828,15 @@ get_featured_app_types() {
 get_target() {
     local app_type="${1:-}"
     
+    if config_snapshot_ready; then
+        if [[ -n "$app_type" && -n "${CFG_APP_TARGET[$app_type]+set}" ]]; then
+            echo "${CFG_APP_TARGET[$app_type]}"
+        else
+            echo "${CFG_META[target]}"
+        fi
+        return 0
+    fi
+    
     if [[ -n "$app_type" ]]; then
         # Check for per-app target override first
         if check_yq; then
@@ -711,22 +845,12 @@ get_target() {
                 echo "$app_target"
                 return 0
             fi
-        else
-            # Fallback: extract per-app target using grep
-            local app_target=$(sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "target:" | sed 's/.*target: *"*\([^"]*\)"*.*/\1/' | head -1)
-            if [[ -n "$app_target" ]]; then
-                echo "$app_target"
-                return 0
-            fi
         fi
     fi
     
     # Fall back to global target
     if check_yq; then
         run_yq '.metadata.target' -r
-    else
-        # Fallback: extract target using grep
-        grep -A 5 "metadata:" "$CONFIG_FILE" | grep "target:" | sed 's/.*target: *"*\([^"]*\)"*.*/\1/'
     fi
 }
 
@@ -734,6 +858,16 @@ get_target() {
 get_idf_version() {
     local app_type="${1:-}"
     
+    if config_snapshot_ready; then
+        if [[ -n "$app_type" && -n "${CFG_APP_IDF_VERSIONS[$app_type]+set}" ]]; then
+            local app_idf_versions=(${CFG_APP_IDF_VERSIONS[$app_type]})
+            echo "${app_idf_versions[0]}"
+        else
+            echo "${CFG_META[default_idf_version]}"
+        fi
+        return 0
+    fi
+    
     if [[ -n "$app_type" ]]; then
         # Check for per-app IDF version override first
         if check_yq; then
@@ -743,14 +877,6 @@ get_idf_version() {
                 echo "$app_idf_versions" | sed 's/\[//' | sed 's/\]//' | sed 's/,.*//' | tr -d '"'
                 return 0
             fi
-        else
-            # Fallback: extract per-app IDF version using grep
-            local app_idf_versions=$(sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "idf_versions:")
-            if [[ -n "$app_idf_versions" ]]; then
-                # Extract first version from array, handling quotes and commas
-                echo "$app_idf_versions" | sed 's/.*\["*\([^",]*\)"*.*/\1/' | tr -d '[]"' | head -1
-                return 0
-            fi
         fi
     fi
     
@@ -758,17 +884,6 @@ get_idf_version() {
     if check_yq; then
         # Get the first IDF version from the array
         run_yq '.metadata.idf_versions[0]' -r
-    else
-        # Fallback: extract IDF version using grep
-        # Extract the first version from the array, handling both ["v1", "v2"] and ["v1"] formats
-        local idf_line=$(grep -A 5 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-        if [[ -n "$idf_line" ]]; then
-            # Extract first version from array, handling quotes and commas
-            echo "$idf_line" | sed 's/.*\["*\([^",]*\)"*.*/\1/' | tr -d '[]"' | head -1
-        else
-            echo "ERROR: Could not extract IDF version from config" >&2
-            return 1
-        fi
     fi
 }
 
@@ -784,26 +899,19 @@ get_idf_version_for_build_type() {
     
     # First, check if the app has specific IDF version requirements
     local app_idf_versions=""
-    if check_yq; then
+    if config_snapshot_ready; then
+        # Snapshot already resolves app overrides against the global versions
+        app_idf_versions="${CFG_APP_IDF_VERSIONS[$app_type]}"
+    elif check_yq; then
         app_idf_versions=$(run_yq ".apps.${app_type}.idf_versions[0]" -r 2>/dev/null)
-    else
-        # Fallback: extract per-app IDF version using grep
-        local app_idf_versions_line=$(sed -n "/^  ${app_type}:/,/^  [a-zA-Z0-9_]*:/p" "$CONFIG_FILE" | grep "idf_versions:")
-        if [[ -n "$app_idf_versions_line" ]]; then
-            app_idf_versions=$(echo "$app_idf_versions_line" | sed 's/.*\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g' | awk '{print $1}')
-        fi
     fi
     
     # If no app-specific versions, use global versions
     if [[ -z "$app_idf_versions" || "$app_idf_versions" == "null" ]]; then
-        if check_yq; then
+        if config_snapshot_ready; then
+            app_idf_versions="${CFG_IDF_VERSION_LIST[*]}"
+        elif check_yq; then
             app_idf_versions=$(run_yq '.metadata.idf_versions | .[]' -r | tr '\n' ' ')
-        else
-            # Fallback: extract global IDF versions
-            local idf_line=$(grep -A 5 "metadata:" "$CONFIG_FILE" | grep "idf_versions:")
-            if [[ -n "$idf_line" ]]; then
-                app_idf_versions=$(echo "$idf_line" | sed 's/.*\[//' | sed 's/\].*//' | sed 's/"//g' | sed 's/,/ /g')
-            fi
         fi
     fi
     
@@ -812,7 +920,12 @@ get_idf_version_for_build_type() {
     for idf_version in "${idf_versions_array[@]}"; do
         if [[ -n "$idf_version" ]]; then
             # Check if this IDF version supports the requested build type
-            if is_valid_build_type "$build_type" "$app_type" "$idf_version"; then
+            if config_snapshot_ready; then
+                if is_valid_combination "$app_type" "$build_type" "$idf_version"; then
+                    echo "$idf_version"
+                    return 0
+                fi
+            elif is_valid_build_type "$build_type" "$app_type" "$idf_version"; then
                 echo "$idf_version"
                 return 0
             fi
@@ -825,6 +938,176 @@ get_idf_version_for_build_type() {
     return 0
 }
 
+# Print "  app - description" lines for the given apps (used by list commands)
+print_app_descriptions() {
+    local app
+    for app in "$@"; do
+        if config_snapshot_ready; then
+            echo "  $app - ${CFG_APP_DESCRIPTION[$app]-}"
+        else
+            echo "  $app - $(get_app_description "$app")"
+        fi
+    done
+}
+
+# Batch query: resolve many configuration keys for one app/build type context
+# Usage: eval "$(config_query [--app <app_type>] [--build-type <type>] [--idf-version <ver>]
+#                             [--target <target>] [--prefix <PREFIX>] [key...])"
+# Keys:
+#   description source_file target idf_version idf_versions build_types project_name
+#   build_dir valid_combination app_types featured_app_types ci_app_types
+#   default_app default_build_type default_idf_version
+# - Without keys, every key that applies to the given context is returned
+# - idf_version: --idf-version if given, else the first app version supporting --build-type
+# - target: --target if given, else the app target override or the global target
+# Prints one shell-safe KEY=value line per key (upper-cased key, optional prefix).
+# With the snapshot loaded all keys come from one in-process pass; otherwise each key
+# is answered by the matching get_* function.
+config_query() {
+    local app_type="" build_type="" idf_version="" target="" prefix=""
+    local keys=()
+    while [[ $# -gt 0 ]]; do
+        case "$1" in
+            --app) app_type="${2:-}"; shift ;;
+            --build-type) build_type="${2:-}"; shift ;;
+            --idf-version) idf_version="${2:-}"; shift ;;
+            --target) target="${2:-}"; shift ;;
+            --prefix) prefix="${2:-}"; shift ;;
+            *) keys+=("$1") ;;
+        esac
+        [[ $# -gt 0 ]] && shift
+    done
+    
+    if [[ ${#keys[@]} -eq 0 ]]; then
+        keys=(default_app default_build_type default_idf_version target)
+        if [[ -n "$app_type" ]]; then
+            keys+=(description source_file idf_version idf_versions build_types project_name)
+            if [[ -n "$build_type" ]]; then
+                keys+=(build_dir valid_combination)
+            fi
+        fi
+    fi
+    
+    local snapshot=false
+    config_snapshot_ready && snapshot=true
+    
+    # Reject unknown apps up front, the lookups below assume a known app
+    if [[ -n "$app_type" ]] && ! is_valid_app_type "$app_type"; then
+        echo "ERROR: config_query: unknown app type: $app_type" >&2
+        return 1
+    fi
+    
+    # Resolve the shared context only when a requested key depends on it
+    local wanted=" ${keys[*]} "
+    local key
+    for key in description source_file project_name build_dir valid_combination; do
+        if [[ -z "$app_type" && "$wanted" == *" $key "* ]]; then
+            echo "ERROR: config_query: key '$key' requires --app" >&2
+            return 1
+        fi
+    done
+    if [[ -z "$target" && "$wanted" =~ \ (target|build_dir|valid_combination)\  ]]; then
+        if $snapshot; then
+            target="${CFG_META[target]}"
+            [[ -n "$app_type" ]] && target="${CFG_APP_TARGET[$app_type]}"
+        else
+            target=$(get_target "$app_type")
+        fi
+    fi
+    if [[ -z "$idf_version" && "$wanted" =~ \ (idf_version|build_dir|valid_combination)\  ]]; then
+        if $snapshot && [[ -n "$app_type" ]]; then
+            local app_versions=(${CFG_APP_IDF_VERSIONS[$app_type]})
+            idf_version="${app_versions[0]}"
+            local version
+            for version in "${app_versions[@]}"; do
+                if [[ -n "$build_type" ]] && config_list_contains "${CFG_APP_IDF_BUILD_TYPES[$app_type|$version]}" "$build_type"; then
+                    idf_version="$version"
+                    break
+                fi
+            done
+        elif $snapshot; then
+            idf_version="${CFG_META[default_idf_version]}"
+        elif [[ -n "$app_type" && -n "$build_type" ]]; then
+            idf_version=$(get_idf_version_for_build_type "$app_type" "$build_type")
+        else
+            idf_version=$(get_idf_version "$app_type")
+        fi
+    fi
+    
+    # Variable names in one tr call: bash 3.2 (no snapshot) has no ${key^^}
+    local names=($(printf '%s\n' "${keys[@]}" | tr '[:lower:]' '[:upper:]'))
+    local value i
+    for i in "${!keys[@]}"; do
+        key="${keys[$i]}"
+        case "$key" in
+            target) value="$target" ;;
+            idf_version) value="$idf_version" ;;
+            build_dir)
+                config_expand_build_directory value "$app_type" "$build_type" "$target" "$idf_version"
+                ;;
+            valid_combination)
+                if is_valid_combination "$app_type" "$build_type" "$idf_version" "$target"; then
+                    value=true
+                else
+                    value=false
+                fi
+                ;;
+            description|source_file|idf_versions|build_types|app_types|featured_app_types|ci_app_types)
+                if $snapshot; then
+                    case "$key" in
+                        description) value="${CFG_APP_DESCRIPTION[$app_type]}" ;;
+                        source_file) value="${CFG_APP_SOURCE_FILE[$app_type]}" ;;
+                        idf_versions)
+                            if [[ -n "$app_type" ]]; then
+                                value="${CFG_APP_IDF_VERSIONS[$app_type]}"
+                            else
+                                value="${CFG_IDF_VERSION_LIST[*]}"
+                            fi
+                            ;;
+                        build_types)
+                            if [[ -n "$app_type" ]]; then
+                                value="${CFG_APP_BUILD_TYPES[$app_type]}"
+                            else
+                                value="${CFG_META[build_types]}"
+                            fi
+                            ;;
+                        app_types) value="${CFG_APP_LIST[*]}" ;;
+                        featured_app_types) value="${CFG_FEATURED_APP_LIST[*]}" ;;
+                        ci_app_types) value="${CFG_CI_APP_LIST[*]}" ;;
+                    esac
+                else
+                    case "$key" in
+                        description) value=$(get_app_description "$app_type") ;;
+                        source_file) value=$(get_app_source_file "$app_type") ;;
+                        idf_versions)
+                            if [[ -n "$app_type" ]]; then
+                                value=$(get_app_idf_versions "$app_type")
+                            else
+                                value=$(get_idf_versions)
+                            fi
+                            ;;
+                        build_types) value=$(get_build_types "$app_type") ;;
+                        app_types) value=$(get_app_types) ;;
+                        featured_app_types) value=$(get_featured_app_types) ;;
+                        ci_app_types) value=$(get_ci_app_types) ;;
+                    esac
+                fi
+                ;;
+            project_name) config_expand_project_name value "$app_type" ;;
+            default_app) value="$CONFIG_DEFAULT_APP" ;;
+            default_build_type) value="$CONFIG_DEFAULT_BUILD_TYPE" ;;
+            default_idf_version) value="$CONFIG_DEFAULT_IDF_VERSION" ;;
+            *)
+                echo "ERROR: config_query: unknown key: $key" >&2
+                return 1
+                ;;
+        esac
+        # Trim the trailing separator left by the space-joined list getters
+        value="${value% }"
+        printf '%s%s=%q\n' "$prefix" "${names[$i]}" "$value"
+    done
+}
+
 # Load configuration
 load_config() {
     if ! [ -f "$CONFIG_FILE" ]; then
@@ -832,12 +1115,14 @@ load_config() {
         return 1
     fi
     
-    if load_config_yq; then
+    if load_config_from_snapshot; then
         return 0
-    else
-        load_config_basic
+    elif load_config_yq; then
         return 0
     fi
+
+    echo "Error: Cannot read $CONFIG_FILE - neither the config snapshot (python3 + PyYAML) nor yq is available" >&2
+    return 1
 }
 
 # Initialize configuration
@@ -860,6 +1145,7 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]]; then
     echo "  # Core configuration"
     echo "  init_config               - Initialize configuration"
     echo "  load_config               - Load configuration and set environment variables"
+    echo "  config_query              - Batch query: many keys for one app/build type context"
     echo ""
     echo "  # App information"
     echo "  get_app_types             - Get all valid app types"
@@ -874,6 +1160,10 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]]; then
     echo "  is_valid_build_type       - Check if build type is valid (with app/IDF version support)"
     echo "  get_build_directory       - Get build directory for app/build type/target/idf_version"
     echo "  get_project_name          - Get project name for app type"
+    echo "  get_build_type_config_value - Get a build_config.build_types setting of a build type"
+    echo "  get_flash_config_value    - Get a flash_config setting (retry_attempts, retry_delay, ...)"
+    echo "  get_app_flash_config_value - Get an app's flash_config setting (baud_rate, flash_mode, ...)"
+    echo "  get_app_monitor_config_value - Get an app's monitor_config setting (baud_rate, ...)"
     echo ""
     echo "  # ESP-IDF and target management"
     echo "  get_target                - Get target from config (with per-app override)"
@@ -994,16 +1284,27 @@ list_build_directories() {
 # =============================================================================
 
 # Check if a complete build combination is valid
-# Usage: is_valid_combination app_type build_type idf_version
+# Usage: is_valid_combination app_type build_type idf_version [target]
 # - app_type: required - the application type
 # - build_type: required - the build configuration
 # - idf_version: required - the ESP-IDF version
+# - target: optional - the MCU target (defaults to the app's resolved target)
 # Returns: 0 if valid combination, 1 if invalid
 # This function provides comprehensive validation for CI pipeline compatibility
+# With the config snapshot loaded this is a single lookup in the precomputed
+# validity set, resolved with the same override rules as generate_matrix.py
 is_valid_combination() {
     local app_type="$1"
     local build_type="$2"
     local idf_version="$3"
+    local target="${4:-}"
+    
+    if config_snapshot_ready; then
+        [[ -n "$app_type" && -n "${CFG_APP_TARGET[$app_type]+set}" ]] || return 1
+        target="${target:-${CFG_APP_TARGET[$app_type]}}"
+        [[ -n "${CFG_VALID_COMBINATIONS[$app_type|$idf_version|$build_type|$target]+set}" ]]
+        return
+    fi
     
     # Check if app type is valid
     if ! is_valid_app_type "$app_type"; then
@@ -1012,12 +1313,13 @@ is_valid_combination() {
     
     # Check if app supports this IDF version
     local app_idf_versions_array=$(get_app_idf_versions_array "$app_type")
-    if ! echo "$app_idf_versions_array" | grep -q "$idf_version"; then
+    if ! config_list_contains "$app_idf_versions_array" "$idf_version"; then
         return 1
     fi
     
-    # Check if build type is valid for this app and IDF version combination
-    if ! is_valid_build_type "$build_type" "$app_type" "$idf_version"; then
+    # Check the build types resolved for this exact app and IDF version
+    local app_version_build_types=$(get_app_build_types_for_idf_version "$app_type" "$idf_version" 2>/dev/null)
+    if ! config_list_contains "$app_version_build_types" "$build_type"; then
         return 1
     fi
     
@@ -1031,11 +1333,15 @@ is_valid_combination() {
 get_app_idf_versions() {
     local app_type="$1"
     
-    if check_yq; then
-        local app_idf_versions=$(run_yq ".apps.${app_type}.idf_versions" -r 2>/dev/null)
+    if config_snapshot_ready; then
+        if [[ -n "${CFG_APP_IDF_VERSIONS[$app_type]+set}" ]]; then
+            echo "${CFG_APP_IDF_VERSIONS[$app_type]}"
+            return 0
+        fi
+    elif check_yq; then
+        local app_idf_versions=$(run_yq ".apps.${app_type}.idf_versions | .[]" -r 2>/dev/null | tr '\n' ' ')
         if [ "$app_idf_versions" != "null" ] && [ -n "$app_idf_versions" ]; then
-            # Extract first version from array
-            echo "$app_idf_versions" | sed 's/\[//g' | sed 's/\]//g' | sed 's/"//g' | tr ',' '\n' | head -n1
+            echo "$app_idf_versions"
             return 0
         fi
     fi
@@ -1048,7 +1354,12 @@ get_app_idf_versions() {
 get_app_idf_versions_array() {
     local app_type="$1"
     
-    if check_yq; then
+    if config_snapshot_ready; then
+        if [[ -n "${CFG_APP_IDF_VERSIONS[$app_type]+set}" ]]; then
+            echo "${CFG_APP_IDF_VERSIONS[$app_type]}"
+            return 0
+        fi
+    elif check_yq; then
         local app_idf_versions=$(run_yq ".apps.${app_type}.idf_versions" -r 2>/dev/null)
         if [ "$app_idf_versions" != "null" ] && [ -n "$app_idf_versions" ]; then
             echo "$app_idf_versions"
@@ -1069,18 +1380,61 @@ show_valid_combinations() {
     echo ""
     echo "   Supported combinations:"
     
-    local app_idf_versions=$(get_app_idf_versions "$app_type")
-    local app_build_types=$(get_build_types "$app_type")
-    
-    # Clean up the build types array
-    local clean_build_types=$(echo "$app_build_types" | sed 's/\[//g' | sed 's/\]//g' | sed 's/"//g' | tr ',' ' ')
+    if config_snapshot_ready; then
+        # Per-version build types straight from the precomputed table
+        local version
+        for version in ${CFG_APP_IDF_VERSIONS[$app_type]}; do
+            echo "     • $version: ${CFG_APP_IDF_BUILD_TYPES[$app_type|$version]}"
+        done
+        return 0
+    fi
     
-    # For each IDF version, show supported build types
-    while IFS= read -r version; do
-        if [ -n "$version" ]; then
-            echo "     • $version: $clean_build_types"
-        fi
-    done < <(echo "$app_idf_versions" | tr ',' '\n')
+    # For each IDF version, show the build types resolved for that version
+    local version
+    for version in $(get_app_idf_versions "$app_type"); do
+        echo "     • $version: $(get_app_build_types_for_idf_version "$app_type" "$version")"
+    done
+}
+
+
+# =============================================================================
+# IDF.PY COMMAND SERVER
+# =============================================================================
+
+# Run idf.py, through the persistent command server (idf_server.py) when IDF_SERVER=1.
+# The server imports the ESP-IDF tooling and checks the Python requirements once per
+# session. Monitor sessions always run directly: they need the terminal as their own.
+# Usage: run_idf_py <idf.py arguments...>
+run_idf_py() {
+    if [[ "$IDF_SERVER" == "1" && -n "$IDF_PATH" && " $* " != *" monitor "* ]]; then
+        python3 "$SCRIPT_DIR/idf_server.py" run -- "$@"
+    else
+        idf.py "$@"
+    fi
+}
+
+# Quote a string for the JSON summaries of parallel builds and flashes
+json_string() {
+    local value="$1"
+    value="${value//\\/\\\\}"
+    value="${value//\"/\\\"}"
+    value="${value//$'\t'/\\t}"
+    value="${value//$'\n'/\\n}"
+    printf '"%s"' "$value"
+}
+
+# ISO 8601 time of a Unix timestamp for the JSON summaries (GNU date -d, BSD date -r)
+iso_time() {
+    date -d "@$1" -Iseconds 2>/dev/null || date -r "$1" +%Y-%m-%dT%H:%M:%S%z
+}
+
+# Write the status line of a parallel build/flash job; the rename makes it appear complete,
+# so the polling parent never reads an empty or partly written file
+# Usage: write_job_status file field...
+write_job_status() {
+    local file="$1"
+    shift
+    echo "$*" > "$file.tmp" && mv -f "$file.tmp" "$file"
 }
 
 
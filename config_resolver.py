@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""
+Shared resolver for the centralized app_config.yml configuration.
+Loads the YAML once (libyaml C loader when available), resolves global
+defaults and per-app overrides in a single place and answers batch queries.
+Used by config_snapshot.py, generate_matrix.py and get_app_info.py so every
+tool sees exactly the same override semantics.
+"""
+
+import sys
+from pathlib import Path
+
+import yaml
+
+# Defaults shared with config_loader.sh
+DEFAULT_IDF_VERSION = "release/v5.5"
+DEFAULT_BUILD_TYPES = ["Debug", "Release"]
+DEFAULT_TARGET = "esp32c6"
+DEFAULT_BUILD_DIRECTORY_PATTERN = "build-app-{app_type}-type-{build_type}-target-{target}-idf-{idf_version}"
+DEFAULT_PROJECT_NAME_PATTERN = "esp32_iid_{app_type}_app"
+
+CONFIG_FILE_NAME = "app_config.yml"
+
+# Prefer the libyaml-backed loader, it is several times faster on large configs
+YAML_LOADER = getattr(yaml, 'CSafeLoader', yaml.SafeLoader)
+
+class ConfigError(Exception):
+    """Raised when the configuration file cannot be found or parsed."""
+
+def find_config_file(project_path=None):
+    """Locate app_config.yml, either in project_path or in the usual locations."""
+    if project_path:
+        config_file = Path(project_path).resolve() / CONFIG_FILE_NAME
+        if not config_file.exists():
+            raise ConfigError(f"Configuration file not found: {config_file}\n"
+                              f"Please check the project path: {project_path}")
+        return config_file
+
+    possible_paths = [
+        # When run from workspace root
+        Path("examples/esp32") / CONFIG_FILE_NAME,
+        # When run from examples/esp32 directory
+        Path(CONFIG_FILE_NAME),
+        # When run from examples/esp32/scripts directory
+        Path("..") / CONFIG_FILE_NAME,
+        # When run from .github/workflows directory
+        Path("../../examples/esp32") / CONFIG_FILE_NAME,
+        # Absolute path calculation from script location
+        Path(__file__).resolve().parent.parent / CONFIG_FILE_NAME,
+    ]
+
+    for path in possible_paths:
+        if path.exists():
+            return path.resolve()
+
+    searched = "\n".join(f"  {path.resolve()}" for path in possible_paths)
+    raise ConfigError(f"Configuration file not found in any of these locations:\n{searched}")
+
+def load_yaml(config_file):
+    """Load a YAML file with the fastest available safe loader."""
+    with open(config_file, 'rb') as f:
+        return yaml.load(f, Loader=YAML_LOADER) or {}
+
+def unique(items):
+    """Return items with duplicates removed, preserving first-seen order."""
+    seen = set()
+    result = []
+    for item in items:
+        if item not in seen:
+            seen.add(item)
+            result.append(item)
+    return result
+
+def resolve_config(config):
+    """Resolve global defaults and per-app overrides into flat lookup tables."""
+    metadata = config.get('metadata', {}) or {}
+    apps = config.get('apps', {}) or {}
+    build_config = config.get('build_config', {}) or {}
+    flash_config = config.get('flash_config', {}) or {}
+    global_flash_config = {k: v for k, v in flash_config.items() if not isinstance(v, (dict, list))}
+
+    idf_versions = metadata.get('idf_versions', [DEFAULT_IDF_VERSION]) or [DEFAULT_IDF_VERSION]
+    build_types_per_idf = metadata.get('build_types', [DEFAULT_BUILD_TYPES]) or [DEFAULT_BUILD_TYPES]
+
+    # Global IDF version -> allowed build types
+    idf_build_types = {}
+    for i, idf_version in enumerate(idf_versions):
+        if i < len(build_types_per_idf):
+            idf_build_types[idf_version] = list(build_types_per_idf[i])
+        else:
+            idf_build_types[idf_version] = list(DEFAULT_BUILD_TYPES)
+
+    # Flattened global build types (config_loader.sh has always sorted these)
+    global_build_types = sorted(set(bt for types in idf_build_types.values() for bt in types))
+
+    # Scalar settings of each build type in build_config.build_types (cmake_build_type, unity_build, ...)
+    build_type_config = {}
+    build_type_definitions = build_config.get('build_types')
+    if isinstance(build_type_definitions, dict):
+        for build_type, settings in build_type_definitions.items():
+            build_type_config[build_type] = {k: v for k, v in (settings or {}).items()
+                                             if not isinstance(v, (dict, list))}
+
+    resolved_apps = {}
+    for app_name, app_config in apps.items():
+        app_config = app_config or {}
+        app_idf_versions = app_config.get('idf_versions') or idf_versions
+        app_build_types_raw = app_config.get('build_types')
+
+        # Per IDF version build types honoring nested, flat and missing overrides
+        per_idf = {}
+        for i, idf_version in enumerate(app_idf_versions):
+            if app_build_types_raw:
+                if isinstance(app_build_types_raw[0], list):
+                    per_idf[idf_version] = list(app_build_types_raw[i]) if i < len(app_build_types_raw) else list(DEFAULT_BUILD_TYPES)
+                else:
+                    per_idf[idf_version] = list(app_build_types_raw)
+            else:
+                per_idf[idf_version] = list(idf_build_types.get(idf_version, DEFAULT_BUILD_TYPES))
+
+        if app_build_types_raw:
+            flat_build_types = unique(bt for types in per_idf.values() for bt in types)
+        else:
+            flat_build_types = global_build_types
+
+        app_target = app_config.get('target') or metadata.get('target', DEFAULT_TARGET)
+        app_flash_config = app_config.get('flash_config') or {}
+        app_monitor_config = app_config.get('monitor_config') or {}
+
+        resolved_apps[app_name] = {
+            'description': app_config.get('description', ''),
+            'source_file': app_config.get('source_file', ''),
+            'target': app_target,
+            'idf_versions': list(app_idf_versions),
+            'build_types': flat_build_types,
+            'idf_build_types': per_idf,
+            'ci_enabled': bool(app_config.get('ci_enabled', True)),
+            'featured': bool(app_config.get('featured', False)),
+            'config_source': 'app' if ('build_types' in app_config or 'idf_versions' in app_config) else 'global',
+            # Global flash_config scalars overridden by the app's own (baud_rate, flash_mode, ...)
+            'flash_config': {**global_flash_config,
+                             **{k: v for k, v in app_flash_config.items() if not isinstance(v, (dict, list))}},
+            'monitor_config': {k: v for k, v in app_monitor_config.items() if not isinstance(v, (dict, list))},
+            # Full (idf_version, build_type, target) validity set for this app
+            'valid_combinations': [
+                {'idf_version': v, 'build_type': bt, 'target': app_target}
+                for v, types in per_idf.items() for bt in types
+            ],
+        }
+
+    return {
+        'metadata': {
+            'default_app': metadata.get('default_app', ''),
+            'default_build_type': metadata.get('default_build_type', ''),
+            'target': metadata.get('target', DEFAULT_TARGET),
+            'default_idf_version': idf_versions[0],
+            'build_types': global_build_types,
+            'build_directory_pattern': build_config.get('build_directory_pattern') or DEFAULT_BUILD_DIRECTORY_PATTERN,
+            'project_name_pattern': build_config.get('project_name_pattern') or DEFAULT_PROJECT_NAME_PATTERN,
+        },
+        'idf_versions': list(idf_versions),
+        'idf_build_types': idf_build_types,
+        # Scalar build_config settings (parallel_builds, cpu_limit, memory_limit, ...)
+        'build_config': {k: v for k, v in build_config.items() if not isinstance(v, (dict, list))},
+        'build_type_config': build_type_config,
+        # Scalar flash_config settings (retry_attempts, retry_delay, flash_timeout, ...)
+        'flash_config': global_flash_config,
+        'apps': resolved_apps,
+    }
+
+class ConfigResolver:
+    """Resolved view of app_config.yml answering batch queries in-process."""
+
+    def __init__(self, config, config_file=None):
+        self.config = config
+        self.config_file = config_file
+        self.resolved = resolve_config(config)
+
+    @classmethod
+    def from_file(cls, config_file):
+        """Create a resolver from an explicit configuration file."""
+        config_file = Path(config_file).resolve()
+        return cls(load_yaml(config_file), config_file)
+
+    @classmethod
+    def from_project(cls, project_path=None):
+        """Create a resolver, locating app_config.yml like the other scripts do."""
+        return cls.from_file(find_config_file(project_path))
+
+    @property
+    def metadata(self):
+        return self.resolved['metadata']
+
+    @property
+    def apps(self):
+        return self.resolved['apps']
+
+    def app_names(self, ci_only=False, featured_only=False):
+        """List app names, optionally restricted to CI-enabled or featured apps."""
+        return [name for name, app in self.apps.items()
+                if (not ci_only or app['ci_enabled']) and (not featured_only or app['featured'])]
+
+    def has_app(self, app_name):
+        return app_name in self.apps
+
+    def app(self, app_name):
+        """Return the resolved settings of one app (KeyError when unknown)."""
+        return self.apps[app_name]
+
+    def build_types(self, app_name=None, idf_version=None):
+        """Build types for the project, an app, or an app/IDF version pair."""
+        if not app_name:
+            if idf_version:
+                return list(self.resolved['idf_build_types'].get(idf_version, []))
+            return list(self.metadata['build_types'])
+        app = self.app(app_name)
+        if idf_version:
+            return list(app['idf_build_types'].get(idf_version, []))
+        return list(app['build_types'])
+
+    def build_type_setting(self, build_type, key, default=None):
+        """A scalar setting of a build type from build_config.build_types."""
+        value = self.resolved['build_type_config'].get(build_type, {}).get(key)
+        return default if value is None else value
+
+    def flash_setting(self, key, default=None):
+        """A scalar setting from flash_config."""
+        value = self.resolved['flash_config'].get(key)
+        return default if value is None else value
+
+    def app_flash_setting(self, app_name, key, default=None):
+        """A flash_config setting of an app, falling back to the global flash_config."""
+        if app_name not in self.apps:
+            return self.flash_setting(key, default)
+        value = self.apps[app_name]['flash_config'].get(key)
+        return default if value is None else value
+
+    def app_monitor_setting(self, app_name, key, default=None):
+        """A monitor_config setting of an app."""
+        value = self.apps.get(app_name, {}).get('monitor_config', {}).get(key)
+        return default if value is None else value
+
+    def idf_versions(self, app_name=None):
+        """ESP-IDF versions for the project or one app."""
+        if app_name:
+            return list(self.app(app_name)['idf_versions'])
+        return list(self.resolved['idf_versions'])
+
+    def is_valid_combination(self, app_name, idf_version, build_type, target=None):
+        """Check an app/IDF version/build type (and optional target) combination."""
+        app = self.apps.get(app_name)
+        if not app or build_type not in app['idf_build_types'].get(idf_version, []):
+            return False
+        return target is None or target == app['target']
+
+    def query(self, app_name, keys):
+        """Return several resolved fields of one app in a single call."""
+        app = self.app(app_name)
+        return {key: app.get(key) for key in keys}
+
+    def matrix_entries(self, ci_only=True):
+        """Expand every app into matrix entries, applying ci_config exclusions."""
+        ci_config = self.config.get('ci_config', {}) or {}
+        exclude_combinations = ci_config.get('exclude_combinations', []) or []
+
+        def is_excluded(entry):
+            # If all keys in an exclusion match the entry, then exclude
+            return any(all(k in entry and entry[k] == v for k, v in exc.items())
+                       for exc in exclude_combinations)
+
+        include = []
+        for app_name in self.app_names(ci_only=ci_only):
+            app = self.apps[app_name]
+            for combo in app['valid_combinations']:
+                idf_version = combo['idf_version']
+                candidate = {
+                    'idf_version': idf_version,  # Git format for ESP-IDF cloning
+                    'idf_version_docker': idf_version.replace('/', '-'),  # Docker-safe format for artifacts
+                    'idf_version_file': idf_version.replace('/', '_').replace('.', '_'),  # File-safe format for build directories
+                    'build_type': combo['build_type'],
+                    'app_name': app_name,
+                    'target': combo['target'],
+                    'config_source': app['config_source'],
+                }
+                if not is_excluded(candidate):
+                    include.append(candidate)
+        return include
+
+def load_resolver(project_path=None, config_file=None):
+    """Create a resolver or exit with an error message (for command line scripts)."""
+    try:
+        if config_file:
+            return ConfigResolver.from_file(config_file)
+        return ConfigResolver.from_project(project_path)
+    except (ConfigError, OSError, yaml.YAMLError) as e:
+        print(f"Error loading configuration: {e}", file=sys.stderr)
+        sys.exit(1)
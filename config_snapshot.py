@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+Compile app_config.yml into a sourceable configuration snapshot.
+This script resolves the whole configuration once and writes a Bash snapshot
+(pre-resolved associative arrays) plus a JSON twin next to the config file.
+config_loader.sh sources the snapshot so every query becomes an in-process lookup.
+Override resolution itself lives in config_resolver.py.
+"""
+
+import sys
+import os
+import json
+import shlex
+import hashlib
+import argparse
+import tempfile
+from pathlib import Path
+
+import yaml
+
+from config_resolver import YAML_LOADER, ConfigResolver
+
+# Bump when the layout of the generated snapshot changes
+SNAPSHOT_FORMAT = 7
+
+# Snapshot file names (stored next to app_config.yml)
+SNAPSHOT_SH_NAME = ".app_config.snapshot.sh"
+SNAPSHOT_JSON_NAME = ".app_config.snapshot.json"
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Configuration Snapshot Compiler")
+    print("")
+    print("Usage: python3 config_snapshot.py <config_file> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --stdout                    - Print the Bash snapshot instead of writing files")
+    print("  --stat <signature>          - Config file stat signature to record (passed by config_loader.sh)")
+    print("")
+    print("PURPOSE:")
+    print("  Resolve app_config.yml once into a compiled snapshot for config_loader.sh")
+    print("")
+    print("OUTPUT FILES (next to the config file):")
+    print(f"  • {SNAPSHOT_SH_NAME}: Bash associative arrays (sourced by config_loader.sh)")
+    print(f"  • {SNAPSHOT_JSON_NAME}: JSON twin of the resolved configuration")
+    print("")
+    print("INVALIDATION:")
+    print("  • Snapshots record the config file's stat signature (size, inode, nanosecond mtime and")
+    print("    ctime) and SHA-256 content hash")
+    print("  • config_loader.sh checks the hash whenever the signature differs or the file changed in")
+    print("    the second the snapshot was written, and recompiles when the hash differs")
+    print("")
+    print("For detailed information, see: docs/README_CONFIG_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Compile app_config.yml into a configuration snapshot",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("config_file", nargs="?", help="Path to app_config.yml")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--stdout", action="store_true", help="Print the Bash snapshot to stdout")
+    parser.add_argument("--stat", default="", help="Stat signature of the config file")
+
+    args = parser.parse_args()
+
+    if args.help or not args.config_file:
+        show_help()
+
+    return args
+
+def bash_assoc(name, mapping):
+    """Render a global Bash associative array declaration."""
+    entries = " ".join(f"[{shlex.quote(str(k))}]={shlex.quote(str(v))}" for k, v in mapping.items())
+    return f"declare -gA {name}=({entries})"
+
+def bash_array(name, items):
+    """Render a global Bash indexed array declaration."""
+    return f"declare -ga {name}=({' '.join(shlex.quote(str(item)) for item in items)})"
+
+def bash_scalar(value):
+    """Render a YAML scalar the way yq prints it (booleans lowercase, null empty)."""
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    return "" if value is None else value
+
+def render_bash(resolved, source, stat_signature, digest):
+    """Render the resolved configuration as a sourceable Bash snapshot."""
+    apps = resolved['apps']
+    meta = dict(resolved['metadata'])
+    meta['build_types'] = " ".join(meta['build_types'])
+
+    lines = [
+        "# Generated by config_snapshot.py - do not edit, regenerated when app_config.yml changes",
+        f"CFG_SNAPSHOT_FORMAT={SNAPSHOT_FORMAT}",
+        f"CFG_SNAPSHOT_STAT={shlex.quote(stat_signature) if stat_signature else '-'}",
+        f"CFG_SNAPSHOT_HASH={digest}",
+        f"CFG_SNAPSHOT_SOURCE={shlex.quote(str(source))}",
+        bash_assoc("CFG_META", meta),
+        bash_assoc("CFG_BUILD_CONFIG", {k: bash_scalar(v) for k, v in resolved['build_config'].items()}),
+        bash_assoc("CFG_BUILD_TYPE_CONFIG", {
+            f"{bt}|{k}": bash_scalar(v) for bt, settings in resolved['build_type_config'].items()
+            for k, v in settings.items()
+        }),
+        bash_assoc("CFG_FLASH_CONFIG", {k: bash_scalar(v) for k, v in resolved['flash_config'].items()}),
+        bash_array("CFG_IDF_VERSION_LIST", resolved['idf_versions']),
+        bash_assoc("CFG_IDF_VERSION_INDEX", {v: i for i, v in enumerate(resolved['idf_versions'])}),
+        bash_assoc("CFG_IDF_BUILD_TYPES", {v: " ".join(t) for v, t in resolved['idf_build_types'].items()}),
+        bash_array("CFG_APP_LIST", apps.keys()),
+        bash_array("CFG_CI_APP_LIST", [a for a, c in apps.items() if c['ci_enabled']]),
+        bash_array("CFG_FEATURED_APP_LIST", [a for a, c in apps.items() if c['featured']]),
+        bash_assoc("CFG_APP_DESCRIPTION", {a: c['description'] for a, c in apps.items()}),
+        bash_assoc("CFG_APP_SOURCE_FILE", {a: c['source_file'] for a, c in apps.items()}),
+        bash_assoc("CFG_APP_TARGET", {a: c['target'] for a, c in apps.items()}),
+        bash_assoc("CFG_APP_IDF_VERSIONS", {a: " ".join(c['idf_versions']) for a, c in apps.items()}),
+        bash_assoc("CFG_APP_BUILD_TYPES", {a: " ".join(c['build_types']) for a, c in apps.items()}),
+        bash_assoc("CFG_APP_IDF_BUILD_TYPES", {
+            f"{a}|{v}": " ".join(t) for a, c in apps.items() for v, t in c['idf_build_types'].items()
+        }),
+        bash_assoc("CFG_APP_FLASH_CONFIG", {
+            f"{a}|{k}": bash_scalar(v) for a, c in apps.items() for k, v in c['flash_config'].items()
+        }),
+        bash_assoc("CFG_APP_MONITOR_CONFIG", {
+            f"{a}|{k}": bash_scalar(v) for a, c in apps.items() for k, v in c['monitor_config'].items()
+        }),
+        # Hash set of every valid app|idf_version|build_type|target combination
+        bash_assoc("CFG_VALID_COMBINATIONS", {
+            f"{a}|{combo['idf_version']}|{combo['build_type']}|{combo['target']}": 1
+            for a, c in apps.items() for combo in c['valid_combinations']
+        }),
+    ]
+    return "\n".join(lines) + "\n"
+
+def write_atomic(path, content):
+    """Write a file atomically so concurrent readers never see partial snapshots."""
+    fd, tmp_path = tempfile.mkstemp(prefix=path.name + ".", dir=path.parent)
+    try:
+        with os.fdopen(fd, 'w') as f:
+            f.write(content)
+        # mkstemp creates 0600 files - apply the usual umask-based permissions
+        umask = os.umask(0)
+        os.umask(umask)
+        os.chmod(tmp_path, 0o666 & ~umask)
+        os.replace(tmp_path, path)
+    except BaseException:
+        if os.path.exists(tmp_path):
+            os.unlink(tmp_path)
+        raise
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    config_file = Path(args.config_file).resolve()
+    try:
+        raw = config_file.read_bytes()
+        config = yaml.load(raw, Loader=YAML_LOADER) or {}
+    except Exception as e:
+        print(f"Error loading configuration: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    digest = hashlib.sha256(raw).hexdigest()
+    resolved = ConfigResolver(config, config_file).resolved
+    bash_snapshot = render_bash(resolved, config_file, args.stat, digest)
+
+    if args.stdout:
+        sys.stdout.write(bash_snapshot)
+        return
+
+    json_snapshot = json.dumps({
+        'format': SNAPSHOT_FORMAT,
+        'source': str(config_file),
+        'stat': args.stat,
+        'sha256': digest,
+        'config': resolved,
+    }, indent=2)
+
+    try:
+        write_atomic(config_file.parent / SNAPSHOT_JSON_NAME, json_snapshot + "\n")
+        write_atomic(config_file.parent / SNAPSHOT_SH_NAME, bash_snapshot)
+    except OSError as e:
+        print(f"Error writing configuration snapshot: {e}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
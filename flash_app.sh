@@ -4,7 +4,7 @@
 # 
 # App types and build types are loaded from app_config.yml
 # Use './flash_app.sh list' to see all available apps
-# Operations: flash, monitor, flash_monitor (default: flash_monitor)
+# Operations: flash, monitor, flash_monitor, flash_session (default: flash_monitor)
 # Logging: --log [log_name] to enable logging with optional custom name
 # NEW: ESP-IDF version parameter for compatibility validation
 
@@ -27,6 +27,47 @@ while [[ $i -le $# ]]; do
                 exit 1
             fi
             ;;
+        --ports)
+            next_i=$((i+1))
+            if [[ $next_i -le $# ]] && [[ "${!next_i}" != -* ]]; then
+                FLASH_PORTS="${!next_i}"
+                ((i++))
+            else
+                echo "ERROR: --ports requires a port list" >&2
+                echo "Usage: --ports /dev/ttyACM0,/dev/ttyACM1" >&2
+                exit 1
+            fi
+            ;;
+        --all-ports)
+            FLASH_ALL_PORTS=1
+            ;;
+        --baud|--monitor-baud)
+            next_i=$((i+1))
+            if [[ $next_i -le $# ]] && [[ "${!next_i}" != -* ]]; then
+                if [ "$arg" = "--baud" ]; then
+                    FLASH_BAUD_OPTION="${!next_i}"
+                else
+                    MONITOR_BAUD_OPTION="${!next_i}"
+                fi
+                ((i++))
+            else
+                echo "ERROR: $arg requires a baud rate" >&2
+                echo "Usage: --baud 921600 (or auto), --monitor-baud 115200" >&2
+                exit 1
+            fi
+            ;;
+        --diff)
+            DIFF_FLASH=1
+            ;;
+        --full-flash)
+            DIFF_FLASH=0
+            ;;
+        --no-fast)
+            FLASH_FAST=0
+            ;;
+        --timestamps)
+            SESSION_TIMESTAMPS=1
+            ;;
         *)
             FILTERED_ARGS+=("$arg")
             ;;
@@ -56,8 +97,10 @@ show_help() {
     echo "COMMANDS:"
     echo "  flash [app] [build_type] [idf_version]     - Flash firmware only"
     echo "  flash_monitor [app] [build_type] [idf_version] - Flash and monitor (default)"
+    echo "  flash_session [app] [build_type] [idf_version] - Flash, reset and monitor over one serial session"
     echo "  monitor [app] [build_type] [idf_version]   - Monitor existing firmware"
     echo "  size [app] [build_type] [idf_version]      - Show firmware size information"
+    echo "  watch [app] [build_type] [idf_version]     - Rebuild and reflash the app partition on every change"
     echo "  list                                        - List available apps and build types"
     echo ""
     echo "ARGUMENT PATTERNS:"
@@ -79,6 +122,14 @@ show_help() {
     echo "OPTIONS:"
     echo "  --project-path <path>                             - Path to project directory (allows scripts to be placed anywhere)"
     echo "  --log [log_name]                                   - Enable logging with optional custom name"
+    echo "  --diff                                             - Differential flash: write only changed sectors"
+    echo "  --all-ports                                        - flash: every detected ESP32 device concurrently"
+    echo "  --ports <list>                                     - flash: the given ports (comma-separated) concurrently"
+    echo "  --full-flash                                       - Always flash every image in full (overrides DIFF_FLASH)"
+    echo "  --baud <rate|auto>                                 - Flash baud rate; auto picks the fastest reliable rate per USB bridge"
+    echo "  --monitor-baud <rate>                              - Monitor baud rate"
+    echo "  --no-fast                                          - flash: always go through the build checks and idf.py"
+    echo "  --timestamps                                       - flash_session: prefix every line with the time since reset"
     echo "  -h, --help                                         - Show this help message"
     echo ""
     echo "ENVIRONMENT VARIABLES:"
@@ -86,9 +137,17 @@ show_help() {
     echo "    - If set, uses this project directory instead of default location"
     echo "    - Allows scripts to be placed anywhere while finding correct project"
     echo "    - Example: PROJECT_PATH=/path/to/project ./flash_app.sh"
+    echo "  ESP32_ARTIFACT_CACHE_DIR                           - Firmware artifact cache used by the auto-build"
+    echo "    - Builds with identical inputs are restored and flashed without compiling"
+    echo "  WATCH_DEBOUNCE                                     - Quiet time in seconds before a watch rebuild (default 0.3)"
+    echo "  DIFF_FLASH                                         - Set to 1 for differential flashing (as --diff)"
+    echo "  ESP32_FLASH_MANIFEST_DIR                           - Per-device flash manifests (default ~/.cache/esp32-flash-manifests)"
+    echo "  ESPBAUD / MONITORBAUD                              - Flash / monitor baud rate (ESPBAUD=auto as --baud auto)"
+    echo "  ESP32_FLASH_BAUD_CACHE                             - Auto-baud cache (default ~/.cache/esp32-flash-baud.json)"
+    echo "  FLASH_FAST                                         - Set to 0 to disable the esptool fast path (as --no-fast)"
     echo ""
     echo "ARGUMENTS:"
-    echo "  operation           - Operation to perform (flash, flash_monitor, monitor, size, list)"
+    echo "  operation           - Operation to perform (flash, flash_monitor, flash_session, monitor, size, watch, list)"
     echo "  app                 - Application type (e.g., gpio_test, adc_test)"
     echo "  build_type          - Build configuration (Debug, Release)"
     echo "  idf_version         - ESP-IDF version (e.g., release/v5.5, release/v5.4)"
@@ -98,7 +157,12 @@ show_help() {
       echo "  # Operation-first syntax (recommended)"
   echo "  ./flash_app.sh flash gpio_test Release release/v5.5"
   echo "  ./flash_app.sh flash_monitor gpio_test Release release/v5.5"
+  echo "  ./flash_app.sh flash_session gpio_test Debug --timestamps   # Boot log from the first ROM byte"
   echo "  ./flash_app.sh size gpio_test Release release/v5.5"
+  echo "  ./flash_app.sh watch gpio_test Debug                  # Edit, save, rebuilt and reflashed"
+  echo "  ./flash_app.sh flash gpio_test Debug --diff           # Write only the changed sectors"
+  echo "  ./flash_app.sh flash gpio_test Release --all-ports    # Every connected board at once"
+  echo "  ./flash_app.sh flash gpio_test Release --ports /dev/ttyACM0,/dev/ttyACM1"
   echo "  ./flash_app.sh monitor"
   echo ""
   echo "  # Portable usage with --project-path flag"
@@ -159,7 +223,7 @@ case $# in
     ;;
 1)
     # One argument - could be operation or app type
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # It's an operation
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -178,7 +242,7 @@ case $# in
     ;;
 2)
     # Two arguments
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # First is operation, second is app type
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -196,7 +260,7 @@ case $# in
     ;;
 3)
     # Three arguments
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # First is operation, second is app type, third is build type
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -206,7 +270,7 @@ case $# in
         fi
     else
         # Check if third argument is an operation
-        if [[ "$3" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+        if [[ "$3" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
             # App-first format: app build_type operation
             OPERATION="$3"
             APP_TYPE="$1"
@@ -223,7 +287,7 @@ case $# in
     ;;
 4)
     # Four arguments - check for logging flag
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # Operation-first format: operation app build_type idf_version
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -241,7 +305,7 @@ case $# in
     ;;
 5)
     # Five arguments - check for logging flag
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # Operation-first format: operation app build_type idf_version --log
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -265,7 +329,7 @@ case $# in
     ;;
 6)
     # Six arguments - check for logging flag and custom name
-    if [[ "$1" =~ ^(flash|flash_monitor|monitor|size|list)$ ]]; then
+    if [[ "$1" =~ ^(flash|flash_monitor|flash_session|monitor|size|watch|list)$ ]]; then
         # Operation-first format: operation app build_type idf_version --log name
         OPERATION="$1"
         if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "list" ]; then
@@ -304,21 +368,16 @@ fi
 
 if [ "$OPERATION" = "list" ]; then
     echo "=== Available App Types ==="
+    eval "$(config_query featured_app_types app_types build_types idf_versions)"
     echo "Featured apps:"
-    for app in $(get_featured_app_types); do
-        description=$(get_app_description "$app")
-        echo "  $app - $description"
-    done
+    print_app_descriptions $FEATURED_APP_TYPES
     echo ""
     echo "All apps:"
-    for app in $(get_app_types); do
-        description=$(get_app_description "$app")
-        echo "  $app - $description"
-    done
+    print_app_descriptions $APP_TYPES
     echo ""
-    echo "Build types: $(get_build_types)"
-    echo "ESP-IDF versions: $(get_idf_versions)"  # NEW: Show available ESP-IDF versions
-    echo "Operations: flash, flash_monitor, monitor"
+    echo "Build types: $BUILD_TYPES"
+    echo "ESP-IDF versions: $IDF_VERSIONS"  # NEW: Show available ESP-IDF versions
+    echo "Operations: flash, flash_monitor, flash_session, monitor"
     echo ""
     echo "Operation details:"
     echo "  <operation> [app_type] [build_type] [idf_version] [--log [log_name]]"
@@ -326,6 +385,7 @@ if [ "$OPERATION" = "list" ]; then
     echo "Operations:"
     echo "  flash [app] [build_type] [idf_version]     - Flash firmware only (app/build type/idf version defaulted if not specified)"
     echo "  flash_monitor [app] [build_type] [idf_version] - Flash and monitor (app/build type/idf version defaulted if not specified)"
+    echo "  flash_session [app] [build_type] [idf_version] - Flash, reset and monitor over one serial session"
     echo "  monitor                          - Monitor existing firmware (no app/build type/idf version needed)"
     echo ""
     echo "Parameter order:"
@@ -353,7 +413,7 @@ if [ "$OPERATION" = "monitor" ]; then
 fi
 
 # NEW: Validate ESP-IDF version and build type compatibility for flash and size operations
-if [[ "$OPERATION" =~ ^(flash|flash_monitor|size)$ ]] && [[ -n "$APP_TYPE" ]]; then
+if [[ "$OPERATION" =~ ^(flash|flash_monitor|flash_session|size|watch)$ ]] && [[ -n "$APP_TYPE" ]]; then
     # Validate combination using enhanced function
     if ! is_valid_combination "$APP_TYPE" "$BUILD_TYPE" "$IDF_VERSION"; then
         echo "ERROR: Invalid combination: $APP_TYPE + $BUILD_TYPE + $IDF_VERSION"
@@ -378,8 +438,172 @@ if [ -z "$IDF_PATH" ] || ! command -v idf.py &> /dev/null; then
     fi
 fi
 
-# Ensure ESP32-C6 target is set
-export IDF_TARGET=$CONFIG_TARGET
+# Target of the app's build: its own target override, else metadata.target
+export IDF_TARGET=$(get_target "$APP_TYPE")
+
+# Resolve app description, build directory and project name in one query
+if [ "$OPERATION" != "monitor" ] && is_valid_app_type "$APP_TYPE"; then
+    eval "$(config_query --app "$APP_TYPE" --build-type "$BUILD_TYPE" --idf-version "$IDF_VERSION" \
+        --target "$IDF_TARGET" description build_dir project_name)"
+fi
+
+# Flash and monitor settings: --baud/--monitor-baud, then ESPBAUD/MONITORBAUD, then the app's
+# flash_config/monitor_config, then the global flash_config. idf.py reads both variables (and
+# would monitor at the flash baud rate without MONITORBAUD).
+FLASH_BAUD="${FLASH_BAUD_OPTION:-${ESPBAUD:-$(get_app_flash_config_value "$APP_TYPE" baud_rate)}}"
+AUTO_BAUD=0
+if [ "$FLASH_BAUD" = "auto" ]; then
+    AUTO_BAUD=1
+    unset ESPBAUD
+elif [[ "$FLASH_BAUD" =~ ^[0-9]+$ ]]; then
+    export ESPBAUD="$FLASH_BAUD"
+elif [ -n "$FLASH_BAUD" ]; then
+    echo "ERROR: Invalid flash baud rate: $FLASH_BAUD (a number or auto)"
+    exit 1
+fi
+MONITOR_BAUD="${MONITOR_BAUD_OPTION:-${MONITORBAUD:-$(get_app_monitor_config_value "$APP_TYPE" baud_rate "$(get_flash_config_value monitor_baud)")}}"
+if [ -z "$MONITOR_BAUD" ] && [[ "$OPERATION" =~ ^(monitor|flash_monitor|flash_session)$ ]]; then
+    MONITOR_BAUD=$(python3 -c 'import json, sys; print(json.load(open(sys.argv[1])).get("monitor_baud", ""))' \
+        "$BUILD_DIR/project_description.json" 2>/dev/null || true)
+fi
+export MONITORBAUD="${MONITOR_BAUD:-115200}"
+
+# Function to detect operating system
+detect_os() {
+    case "$(uname -s)" in
+        Darwin*)    echo "macos" ;;
+        Linux*)     echo "linux" ;;
+        CYGWIN*|MINGW*|MSYS*) echo "windows" ;;
+        *)          echo "unknown" ;;
+    esac
+}
+
+# Function to find ESP32 devices using system-specific methods
+find_esp32_devices() {
+    local os=$(detect_os)
+    local devices=()
+    
+    case "$os" in
+        "macos")
+            # macOS: Look for ESP32 devices in /dev/cu.* (callout devices are better for serial)
+            # ESP32 devices typically appear as usbmodem, usbserial, or similar
+            for port in /dev/cu.usbmodem* /dev/cu.usbserial* /dev/cu.SLAB_USBtoUART* /dev/cu.CP210* /dev/cu.CH340*; do
+                if [ -e "$port" ]; then
+                    devices+=("$port")
+                fi
+            done
+            
+            # Also check /dev/tty.* as fallback
+            for port in /dev/tty.usbmodem* /dev/tty.usbserial* /dev/tty.SLAB_USBtoUART* /dev/tty.CP210* /dev/tty.CH340*; do
+                if [ -e "$port" ]; then
+                    devices+=("$port")
+                fi
+            done
+            ;;
+            
+        "linux")
+            # Linux: Check for ESP32 devices in /dev/ttyACM* and /dev/ttyUSB*
+            # ESP32-C6 typically uses /dev/ttyACM*, older ESP32 uses /dev/ttyUSB*
+            for port in /dev/ttyACM* /dev/ttyUSB*; do
+                if [ -e "$port" ]; then
+                    devices+=("$port")
+                fi
+            done
+            
+            # Also check for specific ESP32 device names if available
+            if command -v lsusb &> /dev/null; then
+                # Look for ESP32-related USB devices
+                if lsusb | grep -q "Silicon Labs\|CP210\|CH340\|ESP\|Espressif"; then
+                    # Silent detection - no output needed here
+                    :
+                fi
+            fi
+            ;;
+            
+        *)
+            # Silent warning for unsupported OS
+            :
+            ;;
+    esac
+    
+    # Return devices as space-separated string
+    echo "${devices[@]}"
+}
+
+# Function to find the best available port
+find_best_port() {
+    local os=$(detect_os)
+    local esp32_devices=($(find_esp32_devices))
+    local fallback_ports=()
+    
+    # First priority: ESP32-specific devices
+    if [ ${#esp32_devices[@]} -gt 0 ]; then
+        # Prefer callout devices on macOS (cu.* over tty.*)
+        if [ "$os" = "macos" ]; then
+            for port in "${esp32_devices[@]}"; do
+                if [[ "$port" == "/dev/cu."* ]]; then
+                    echo "$port"
+                    return 0
+                fi
+            done
+        fi
+        
+        # Use first ESP32 device found
+        echo "${esp32_devices[0]}"
+        return 0
+    fi
+    
+    # Second priority: Fallback to common serial ports
+    case "$os" in
+        "macos")
+            # macOS fallback ports
+            for port in /dev/cu.usbmodem* /dev/cu.usbserial* /dev/cu.*; do
+                if [ -e "$port" ] && [[ "$port" != "/dev/cu.Bluetooth"* ]] && [[ "$port" != "/dev/cu.debug"* ]] && [[ "$port" != "/dev/cu.wlan"* ]]; then
+                    fallback_ports+=("$port")
+                fi
+            done
+            ;;
+        "linux")
+            # Linux fallback ports
+            for port in /dev/ttyACM* /dev/ttyUSB* /dev/ttyS*; do
+                if [ -e "$port" ]; then
+                    fallback_ports+=("$port")
+                fi
+            done
+            ;;
+    esac
+    
+    if [ ${#fallback_ports[@]} -gt 0 ]; then
+        echo "Using fallback port: ${fallback_ports[0]}"
+        echo "${fallback_ports[0]}"
+        return 0
+    fi
+    
+    # No ports found
+    return 1
+}
+
+# Fast path for flash-only runs on an up-to-date build: flash_fast.py runs esptool in-process
+# with the options of flasher_args.json, as idf.py flash would, without the build checks below
+# and idf.py's CMake re-validation. Exit code 3: not applicable here, take the normal path.
+if [ "$OPERATION" = "flash" ] && [ "$FLASH_FAST" != "0" ] && [ "$DIFF_FLASH" != "1" ] && [ "$AUTO_BAUD" != "1" ] \
+   && [ "$ENABLE_LOGGING" != true ] && [ -z "$FLASH_PORTS" ] && [ "$FLASH_ALL_PORTS" != "1" ] \
+   && [ -f "$BUILD_DIR/flasher_args.json" ]; then
+    FAST_STATUS=0
+    # The port the normal path would pick, so both paths write to the same device
+    FAST_PORT=$(find_best_port | tail -n 1) || true
+    python3 "$SCRIPT_DIR/flash_fast.py" "$BUILD_DIR" --project-dir "$PROJECT_DIR" --port "$FAST_PORT" \
+        --flash-mode "$(get_app_flash_config_value "$APP_TYPE" flash_mode)" \
+        --flash-freq "$(get_app_flash_config_value "$APP_TYPE" flash_freq)" \
+        --flash-size "$(get_app_flash_config_value "$APP_TYPE" flash_size)" || FAST_STATUS=$?
+    if [ "$FAST_STATUS" = "0" ]; then
+        echo "Flash completed successfully!"
+        exit 0
+    elif [ "$FAST_STATUS" != "3" ]; then
+        echo "ERROR: Flash operation failed"
+        exit 1
+    fi
+fi
 
 echo "=== ESP32 HardFOC Interface Wrapper Flash System ==="
 echo "Project Directory: $PROJECT_DIR"
@@ -402,8 +626,7 @@ echo "======================================================"
 if [ "$OPERATION" != "monitor" ]; then
     if is_valid_app_type "$APP_TYPE"; then
         echo "Valid app type: $APP_TYPE"
-        description=$(get_app_description "$APP_TYPE")
-        echo "Description: $description"
+        echo "Description: $DESCRIPTION"
     else
         echo "ERROR: Invalid app type: $APP_TYPE"
         echo "Available types: $(get_app_types)"
@@ -425,12 +648,12 @@ fi
 
 # Validate operation
 case $OPERATION in
-    flash|monitor|flash_monitor|size)
+    flash|monitor|flash_monitor|flash_session|size|watch)
         echo "Valid operation: $OPERATION"
         ;;
     *)
         echo "ERROR: Invalid operation: $OPERATION"
-        echo "Available operations: flash, monitor, flash_monitor, size"
+        echo "Available operations: flash, monitor, flash_monitor, flash_session, size, watch"
         exit 1
         ;;
 esac
@@ -440,11 +663,9 @@ cd "$PROJECT_DIR"
 
 # Set build directory using configuration (same logic as build_app.sh)
 if [ "$OPERATION" != "monitor" ]; then
-    BUILD_DIR=$(get_build_directory "$APP_TYPE" "$BUILD_TYPE")
     echo "Build directory: $BUILD_DIR"
 
-    # Get project information using configuration
-    PROJECT_NAME=$(get_project_name "$APP_TYPE")
+    # Project information (BUILD_DIR and PROJECT_NAME resolved by config_query above)
     BIN_FILE="$BUILD_DIR/$PROJECT_NAME.bin"
     echo "Expected binary: $BIN_FILE"
     echo "Project name: $PROJECT_NAME"
@@ -456,8 +677,8 @@ else
     echo "Monitor operation - no build directory needed"
 fi
 
-# Check if build exists and is valid (skip for monitor operation)
-if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ]; then
+# Check if build exists and is valid (skip for monitor operation; watch builds on its own)
+if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ] && [ "$OPERATION" != "watch" ]; then
     BUILD_EXISTS=false
     if [ -d "$BUILD_DIR" ]; then
         # Check for multiple indicators of a valid build
@@ -496,8 +717,8 @@ else
     BUILD_EXISTS=true
 fi
 
-# Auto-build if necessary (skip for monitor and size operations)
-if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ] && [ "$BUILD_EXISTS" = false ]; then
+# Auto-build if necessary (skip for monitor, size and watch operations)
+if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ] && [ "$OPERATION" != "watch" ] && [ "$BUILD_EXISTS" = false ]; then
     echo ""
     echo "======================================================"
     echo "NO VALID BUILD FOUND - STARTING AUTO-BUILD"
@@ -524,8 +745,9 @@ if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ] && [ "$BUILD_EXIS
     echo "Calling build_app.sh to ensure consistent build process..."
     echo ""
     
-    # Call build_app.sh with the same parameters
-    if ! "$(dirname "${BASH_SOURCE[0]}")/build_app.sh" "$APP_TYPE" "$BUILD_TYPE"; then
+    # Call build_app.sh with the same parameters (restores from the artifact cache when the
+    # same inputs were built before, e.g. by CI or another checkout)
+    if ! "$(dirname "${BASH_SOURCE[0]}")/build_app.sh" "$APP_TYPE" "$BUILD_TYPE" "$IDF_VERSION"; then
         echo "ERROR: Build failed - see build_app.sh output above"
         exit 1
     fi
@@ -534,12 +756,14 @@ if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "size" ] && [ "$BUILD_EXIS
     echo "=================================================="
 elif [ "$OPERATION" = "monitor" ]; then
     echo "Monitor operation - no build needed"
+elif [ "$OPERATION" = "watch" ]; then
+    echo "Watch operation - build_app.sh --watch builds before watching"
 else
     echo "Using existing build in $BUILD_DIR"
 fi
 
 # Verify binary exists after build (skip for monitor operation)
-if [ "$OPERATION" != "monitor" ] && [ ! -f "$BIN_FILE" ] && [ ! -f "$BUILD_DIR/bootloader/bootloader.bin" ]; then
+if [ "$OPERATION" != "monitor" ] && [ "$OPERATION" != "watch" ] && [ ! -f "$BIN_FILE" ] && [ ! -f "$BUILD_DIR/bootloader/bootloader.bin" ]; then
     echo "ERROR: No valid binary found after build attempt"
     echo "Expected: $BIN_FILE"
     echo "Build directory contents:"
@@ -553,121 +777,6 @@ echo "======================================================"
 echo "SMART PORT DETECTION AND PERMISSION HANDLING"
 echo "======================================================"
 
-# Function to detect operating system
-detect_os() {
-    case "$(uname -s)" in
-        Darwin*)    echo "macos" ;;
-        Linux*)     echo "linux" ;;
-        CYGWIN*|MINGW*|MSYS*) echo "windows" ;;
-        *)          echo "unknown" ;;
-    esac
-}
-
-# Function to find ESP32 devices using system-specific methods
-find_esp32_devices() {
-    local os=$(detect_os)
-    local devices=()
-    
-    case "$os" in
-        "macos")
-            # macOS: Look for ESP32 devices in /dev/cu.* (callout devices are better for serial)
-            # ESP32 devices typically appear as usbmodem, usbserial, or similar
-            for port in /dev/cu.usbmodem* /dev/cu.usbserial* /dev/cu.SLAB_USBtoUART* /dev/cu.CP210* /dev/cu.CH340*; do
-                if [ -e "$port" ]; then
-                    devices+=("$port")
-                fi
-            done
-            
-            # Also check /dev/tty.* as fallback
-            for port in /dev/tty.usbmodem* /dev/tty.usbserial* /dev/tty.SLAB_USBtoUART* /dev/tty.CP210* /dev/tty.CH340*; do
-                if [ -e "$port" ]; then
-                    devices+=("$port")
-                fi
-            done
-            ;;
-            
-        "linux")
-            # Linux: Check for ESP32 devices in /dev/ttyACM* and /dev/ttyUSB*
-            # ESP32-C6 typically uses /dev/ttyACM*, older ESP32 uses /dev/ttyUSB*
-            for port in /dev/ttyACM* /dev/ttyUSB*; do
-                if [ -e "$port" ]; then
-                    devices+=("$port")
-                fi
-            done
-            
-            # Also check for specific ESP32 device names if available
-            if command -v lsusb &> /dev/null; then
-                # Look for ESP32-related USB devices
-                if lsusb | grep -q "Silicon Labs\|CP210\|CH340\|ESP\|Espressif"; then
-                    # Silent detection - no output needed here
-                    :
-                fi
-            fi
-            ;;
-            
-        *)
-            # Silent warning for unsupported OS
-            :
-            ;;
-    esac
-    
-    # Return devices as space-separated string
-    echo "${devices[@]}"
-}
-
-# Function to find the best available port
-find_best_port() {
-    local os=$(detect_os)
-    local esp32_devices=($(find_esp32_devices))
-    local fallback_ports=()
-    
-    # First priority: ESP32-specific devices
-    if [ ${#esp32_devices[@]} -gt 0 ]; then
-        # Prefer callout devices on macOS (cu.* over tty.*)
-        if [ "$os" = "macos" ]; then
-            for port in "${esp32_devices[@]}"; do
-                if [[ "$port" == "/dev/cu."* ]]; then
-                    echo "$port"
-                    return 0
-                fi
-            done
-        fi
-        
-        # Use first ESP32 device found
-        echo "${esp32_devices[0]}"
-        return 0
-    fi
-    
-    # Second priority: Fallback to common serial ports
-    case "$os" in
-        "macos")
-            # macOS fallback ports
-            for port in /dev/cu.usbmodem* /dev/cu.usbserial* /dev/cu.*; do
-                if [ -e "$port" ] && [[ "$port" != "/dev/cu.Bluetooth"* ]] && [[ "$port" != "/dev/cu.debug"* ]] && [[ "$port" != "/dev/cu.wlan"* ]]; then
-                    fallback_ports+=("$port")
-                fi
-            done
-            ;;
-        "linux")
-            # Linux fallback ports
-            for port in /dev/ttyACM* /dev/ttyUSB* /dev/ttyS*; do
-                if [ -e "$port" ]; then
-                    fallback_ports+=("$port")
-                fi
-            done
-            ;;
-    esac
-    
-    if [ ${#fallback_ports[@]} -gt 0 ]; then
-        echo "Using fallback port: ${fallback_ports[0]}"
-        echo "${fallback_ports[0]}"
-        return 0
-    fi
-    
-    # No ports found
-    return 1
-}
-
 # Function to fix port permissions (Linux-specific)
 fix_port_permissions() {
     local port="$1"
@@ -732,6 +841,310 @@ validate_port() {
     return 0  # Still allow it as it might work
 }
 
+# Function to write the build once at the current baud rate: idf.py for configured build
+# directories, esptool directly for builds restored from the artifact cache (idf.py would
+# configure and compile them first) or when flash_config overrides the build's flash settings.
+# With --diff, flash_diff.py writes only the sectors that differ from the chip; a full flash
+# follows whenever that is not possible or fails.
+write_firmware() {
+    if [ "$DIFF_FLASH" = "1" ]; then
+        # idf.py flash builds first: so does the differential flash
+        if [ -f "$BUILD_DIR/build.ninja" ] && ! run_idf_py -B "$BUILD_DIR" build; then
+            return 1
+        fi
+        if python3 "$SCRIPT_DIR/flash_diff.py" "$BUILD_DIR" --port "$BEST_PORT" --chip "$IDF_TARGET"; then
+            return 0
+        fi
+        echo "Differential flash failed or unavailable: flashing in full"
+    fi
+
+    if [ ${#FLASH_PARAM_ARGS[@]} -gt 0 ] && [ -f "$BUILD_DIR/flash_args" ]; then
+        if [ -f "$BUILD_DIR/build.ninja" ] && ! run_idf_py -B "$BUILD_DIR" build; then
+            return 1
+        fi
+        echo "Flashing with esptool: ${FLASH_PARAM_ARGS[*]} from flash_config"
+        esptool_flash "$BEST_PORT"
+        return
+    fi
+
+    if [ -f "$BUILD_DIR/build.ninja" ] || [ ! -f "$BUILD_DIR/flash_args" ]; then
+        run_idf_py -B "$BUILD_DIR" -p "$BEST_PORT" flash
+        return
+    fi
+
+    echo "Build restored from the artifact cache: flashing with esptool"
+    esptool_flash "$BEST_PORT"
+}
+
+# Function to flash the build. With --baud auto the rates of flash_baud.py are tried from the
+# fastest: a failure after esptool changed the baud rate steps down to the next rate, any other
+# failure (no connection, build error) ends the attempt. The rate that worked is cached per bridge.
+flash_firmware() {
+    if [ "$AUTO_BAUD" != "1" ]; then
+        write_firmware
+        return
+    fi
+
+    local rates rate attempt_log rc=1
+    rates=$(python3 "$SCRIPT_DIR/flash_baud.py" rates "$BEST_PORT") || rates="460800"
+    attempt_log=$(mktemp)
+    for rate in $rates; do
+        echo "Flashing at $rate baud..."
+        ESPBAUD="$rate" write_firmware 2>&1 | tee "$attempt_log"
+        rc=${PIPESTATUS[0]}
+        if [ "$rc" -eq 0 ]; then
+            python3 "$SCRIPT_DIR/flash_baud.py" record "$BEST_PORT" "$rate" || true
+            break
+        fi
+        if ! grep -q "Changing baud rate" "$attempt_log"; then
+            break
+        fi
+        echo "Flashing at $rate baud failed: stepping down"
+    done
+    rm -f "$attempt_log"
+    return "$rc"
+}
+
+# esptool options for the flash_mode/flash_freq/flash_size of the app's flash_config that differ
+# from the build (flasher_args.json); esptool rewrites the bootloader header with them
+flash_param_overrides() {
+    local key value built
+    local args=()
+    for key in flash_mode flash_freq flash_size; do
+        value=$(get_app_flash_config_value "$APP_TYPE" "$key")
+        if [ -z "$value" ]; then
+            continue
+        fi
+        built=$(python3 -c 'import json, sys; print(json.load(open(sys.argv[1])).get("flash_settings", {}).get(sys.argv[2], ""))' \
+            "$BUILD_DIR/flasher_args.json" "$key" 2>/dev/null || true)
+        if [ "$value" != "$built" ]; then
+            args+=("--$key" "$value")
+        fi
+    done
+    # One line: the caller splits it into an array with read -a
+    echo "${args[*]}"
+}
+
+# Write every image of flash_args to one port with esptool (no build step, safe to run
+# concurrently). Further arguments prefix the esptool command (e.g. timeout 120).
+esptool_flash() {
+    local port="$1"
+    shift
+    local esptool=(python3 -m esptool)
+    if command -v esptool.py &> /dev/null; then
+        esptool=(esptool.py)
+    fi
+    (cd "$BUILD_DIR" && "$@" "${esptool[@]}" --chip "$IDF_TARGET" -p "$port" -b "${ESPBAUD:-460800}" \
+        --before default_reset --after hard_reset write_flash @flash_args "${FLASH_PARAM_ARGS[@]}")
+}
+
+# Flash one device with retries (flash_config.retry_attempts/retry_delay) and a per-attempt
+# timeout (flash_config.flash_timeout); output goes to the device's log, events to stdout.
+# Writes "<exit code> <attempts> <end time>" to the status file.
+flash_device() {
+    local port="$1" log="$2" status_file="$3"
+    local retries delay flash_timeout
+    retries=$(get_flash_config_value retry_attempts 3)
+    delay=$(get_flash_config_value retry_delay 2)
+    flash_timeout=$(get_flash_config_value flash_timeout 120)
+    local limit=()
+    if command -v timeout &> /dev/null; then
+        limit=(timeout "$flash_timeout")
+    fi
+
+    # --baud auto: start at the bridge's best rate, step down after a failure at that rate
+    local rates=() rate_index=0 log_offset
+    if [ "$AUTO_BAUD" = "1" ]; then
+        read -r -a rates <<< "$(python3 "$SCRIPT_DIR/flash_baud.py" rates "$port" 2>> "$log" || echo 460800)"
+    fi
+
+    local attempt=0 rc=1
+    while [ "$attempt" -le "$retries" ]; do
+        attempt=$(( attempt + 1 ))
+        echo "=== Attempt $attempt/$(( retries + 1 )) on $port ===" >> "$log"
+        log_offset=$(wc -c < "$log")
+        if [ ${#rates[@]} -gt 0 ]; then
+            export ESPBAUD="${rates[$rate_index]}"
+            echo "Baud rate: $ESPBAUD" >> "$log"
+        fi
+        rc=0
+        if [ "$DIFF_FLASH" = "1" ]; then
+            "${limit[@]}" python3 "$SCRIPT_DIR/flash_diff.py" "$BUILD_DIR" --port "$port" --chip "$IDF_TARGET" \
+                >> "$log" 2>&1 < /dev/null || rc=$?
+        fi
+        if [ "$DIFF_FLASH" != "1" ] || [ "$rc" = "3" ]; then
+            rc=0
+            esptool_flash "$port" "${limit[@]}" >> "$log" 2>&1 < /dev/null || rc=$?
+        fi
+        if [ "$rc" = "0" ]; then
+            if [ ${#rates[@]} -gt 0 ]; then
+                python3 "$SCRIPT_DIR/flash_baud.py" record "$port" "$ESPBAUD" >> "$log" 2>&1 || true
+            fi
+            break
+        fi
+        if [ $(( rate_index + 1 )) -lt ${#rates[@]} ] && \
+            tail -c +$(( log_offset + 1 )) "$log" | grep -q "Changing baud rate"; then
+            rate_index=$(( rate_index + 1 ))
+            echo "[$port] stepping down to ${rates[$rate_index]} baud"
+        fi
+        if [ "$rc" = "124" ]; then
+            echo "[$port] attempt $attempt timed out after ${flash_timeout}s"
+        else
+            echo "[$port] attempt $attempt failed (exit $rc)"
+        fi
+        if [ "$attempt" -le "$retries" ]; then
+            sleep "$delay"
+        fi
+    done
+    write_job_status "$status_file" "$rc" "$attempt" "$(date +%s)"
+}
+
+# Flash the same build to several devices at once: --all-ports (every detected ESP32 device)
+# or --ports <list>. Each device has its own log, retries and timeout; the run ends with a
+# pass/fail line per device and flash_report.json in logs/flash/<timestamp>/.
+run_multi_flash() {
+    local ports=() port
+    if [ "$FLASH_ALL_PORTS" = "1" ]; then
+        for port in $(find_esp32_devices); do
+            # macOS lists each device as cu.* and tty.*: keep the callout device
+            if [[ "$port" == /dev/tty.* ]] && [ -e "/dev/cu.${port#/dev/tty.}" ]; then
+                continue
+            fi
+            ports+=("$port")
+        done
+    fi
+    for port in ${FLASH_PORTS//,/ }; do
+        if [[ " ${ports[*]} " != *" $port "* ]]; then
+            ports+=("$port")
+        fi
+    done
+    local total=${#ports[@]}
+    if [ "$total" -eq 0 ]; then
+        echo "ERROR: No ESP32 devices found to flash"
+        return 1
+    fi
+
+    # idf.py flash would build in every job: build once, then only write images
+    if [ -f "$BUILD_DIR/build.ninja" ] && ! run_idf_py -B "$BUILD_DIR" build; then
+        echo "ERROR: Build failed"
+        return 1
+    fi
+    if [ ! -f "$BUILD_DIR/flash_args" ]; then
+        echo "ERROR: $BUILD_DIR/flash_args not found"
+        return 1
+    fi
+
+    local run_id
+    run_id=$(date +%Y%m%d_%H%M%S)
+    local log_dir="$LOG_DIR/flash/$run_id"
+    local status_dir="$log_dir/.status"
+    mkdir -p "$status_dir"
+
+    echo "=== ESP32 Multi-Device Flash ==="
+    echo "Devices: $total"
+    echo "Retries per device: $(get_flash_config_value retry_attempts 3) (delay $(get_flash_config_value retry_delay 2)s)"
+    echo "Log directory: $log_dir"
+    echo "======================================================="
+
+    local -a device_log=() device_rc=() device_attempts=() device_end=() device_mac=()
+    local -A running=()
+    local index started_at
+    started_at=$(date +%s)
+    for index in "${!ports[@]}"; do
+        port="${ports[$index]}"
+        device_log[$index]="$log_dir/$(basename "$port").log"
+        if ! validate_port "$port" > "${device_log[$index]}" 2>&1; then
+            write_job_status "$status_dir/$index" 1 0 "$(date +%s)"
+            continue
+        fi
+        fix_port_permissions "$port" >> "${device_log[$index]}" 2>&1
+        echo "[start] $port"
+        flash_device "$port" "${device_log[$index]}" "$status_dir/$index" &
+        running[$!]=$index
+    done
+
+    local finished=0 failed=0 pid rc attempts end progress
+    while [ "$finished" -lt "$total" ]; do
+        # A job that died without reporting counts as failed
+        for pid in "${!running[@]}"; do
+            if ! kill -0 "$pid" 2>/dev/null; then
+                if [ ! -f "$status_dir/${running[$pid]}" ]; then
+                    write_job_status "$status_dir/${running[$pid]}" 255 0 "$(date +%s)"
+                fi
+                unset "running[$pid]"
+            fi
+        done
+        for index in "${!ports[@]}"; do
+            if [ -n "${device_rc[$index]}" ] || [ ! -f "$status_dir/$index" ]; then
+                continue
+            fi
+            read -r rc attempts end < "$status_dir/$index"
+            device_rc[$index]=$rc
+            device_attempts[$index]=$attempts
+            device_end[$index]=$end
+            device_mac[$index]=$(sed -n 's/^MAC: *//p; s/^Device \([0-9a-f:]*\) .*/\1/p' "${device_log[$index]}" | head -n 1)
+            finished=$(( finished + 1 ))
+            [ -t 1 ] && printf '\r\033[K'
+            if [ "$rc" -eq 0 ]; then
+                echo "[$finished/$total] ✅ ${ports[$index]} ${device_mac[$index]} ($(( end - started_at ))s, $attempts attempt(s))"
+            else
+                failed=$(( failed + 1 ))
+                echo "[$finished/$total] ❌ ${ports[$index]} (exit $rc after $attempts attempt(s)) - see ${device_log[$index]}"
+            fi
+        done
+        if [ "$finished" -lt "$total" ]; then
+            # Live progress (esptool's "(NN %)") of the devices still flashing
+            if [ -t 1 ]; then
+                progress=""
+                for index in "${!ports[@]}"; do
+                    if [ -z "${device_rc[$index]}" ]; then
+                        progress+=" $(basename "${ports[$index]}"):$(tail -c 2048 "${device_log[$index]}" 2>/dev/null | grep -o '[0-9]* %' | tail -n 1 | tr -d ' ')"
+                    fi
+                done
+                printf '\r\033[K[flashing]%s' "$progress"
+            fi
+            sleep 1
+        fi
+    done
+    wait
+    rm -rf "$status_dir"
+
+    local finished_at
+    finished_at=$(date +%s)
+    local report_file="$log_dir/flash_report.json"
+    {
+        echo "{"
+        echo "  \"started\": $(json_string "$(iso_time "$started_at")"),"
+        echo "  \"duration_s\": $(( finished_at - started_at )),"
+        echo "  \"app_type\": $(json_string "$APP_TYPE"),"
+        echo "  \"build_type\": $(json_string "$BUILD_TYPE"),"
+        echo "  \"build_dir\": $(json_string "$BUILD_DIR"),"
+        echo "  \"differential\": $([ "$DIFF_FLASH" = "1" ] && echo true || echo false),"
+        echo "  \"total\": $total,"
+        echo "  \"passed\": $(( total - failed )),"
+        echo "  \"failed\": $failed,"
+        echo "  \"devices\": ["
+        local separator=","
+        for index in "${!ports[@]}"; do
+            if [ "$index" -eq $(( total - 1 )) ]; then
+                separator=""
+            fi
+            echo "    {\"port\": $(json_string "${ports[$index]}"), \"mac\": $(json_string "${device_mac[$index]}")," \
+                 "\"status\": \"$([ "${device_rc[$index]}" -eq 0 ] && echo pass || echo fail)\"," \
+                 "\"exit_code\": ${device_rc[$index]}, \"attempts\": ${device_attempts[$index]}," \
+                 "\"duration_s\": $(( device_end[index] - started_at )), \"log\": $(json_string "${device_log[$index]}")}$separator"
+        done
+        echo "  ]"
+        echo "}"
+    } > "$report_file"
+
+    echo "======================================================="
+    echo "Multi-device flash finished in $(( finished_at - started_at ))s: $(( total - failed ))/$total passed"
+    echo "Report: $report_file"
+    [ "$failed" -eq 0 ]
+}
+
+
 # Function to setup logging directory and generate log filename
 setup_logging() {
     if [ "$ENABLE_LOGGING" != true ]; then
@@ -813,6 +1226,30 @@ cleanup_old_logs() {
     fi
 }
 
+FLASH_PARAM_ARGS=()
+if [[ "$OPERATION" =~ ^(flash|flash_monitor|flash_session)$ ]]; then
+    read -r -a FLASH_PARAM_ARGS <<< "$(flash_param_overrides)"
+    if [ ${#FLASH_PARAM_ARGS[@]} -gt 0 ] && [ "$DIFF_FLASH" = "1" ]; then
+        echo "flash_config overrides the build's flash settings: flashing in full instead of differentially"
+        DIFF_FLASH=0
+    fi
+fi
+if [ "$OPERATION" != "size" ]; then
+    echo "Flash baud rate: ${FLASH_BAUD:-ESP-IDF default}, monitor baud rate: $MONITORBAUD"
+fi
+
+# Several devices at once (flash only): their own port handling, logs and report
+if [ "$FLASH_ALL_PORTS" = "1" ] || [ -n "$FLASH_PORTS" ]; then
+    if [ "$OPERATION" != "flash" ]; then
+        echo "ERROR: --all-ports/--ports are only supported by the flash operation"
+        exit 1
+    fi
+    if run_multi_flash; then
+        exit 0
+    fi
+    exit 1
+fi
+
 # Find and configure the best available port (skip for size operations)
 if [ "$OPERATION" != "size" ]; then
     echo "Searching for ESP32 devices..."
@@ -913,12 +1350,27 @@ echo "======================================================"
 case $OPERATION in
     flash)
         echo "Flashing $APP_TYPE app to $BEST_PORT..."
-        if ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" flash; then
+        if ! flash_firmware; then
             echo "ERROR: Flash operation failed"
             exit 1
         fi
         echo "Flash completed successfully!"
         ;;
+    watch)
+        # build_app.sh keeps the configuration and ESP-IDF environment loaded, rebuilds with
+        # ninja on every change and flashes the app partition to the detected port
+        echo "Watching $APP_TYPE sources, reflashing $BEST_PORT after each rebuild (Ctrl+C to stop)..."
+        if [ "$AUTO_BAUD" = "1" ]; then
+            # No stepping down between rebuilds: the bridge's cached (or fastest) rate
+            ESPBAUD=$(python3 "$SCRIPT_DIR/flash_baud.py" rates "$BEST_PORT" | cut -d' ' -f1) || ESPBAUD=460800
+            export ESPBAUD
+        fi
+        if [ "$ENABLE_LOGGING" = true ]; then
+            DIFF_FLASH="$DIFF_FLASH" WATCH_FLASH_PORT="$BEST_PORT" "$SCRIPT_DIR/build_app.sh" --watch "$APP_TYPE" "$BUILD_TYPE" "$IDF_VERSION" 2>&1 | tee -a "$LOG_FILEPATH"
+            exit "${PIPESTATUS[0]}"
+        fi
+        DIFF_FLASH="$DIFF_FLASH" WATCH_FLASH_PORT="$BEST_PORT" exec "$SCRIPT_DIR/build_app.sh" --watch "$APP_TYPE" "$BUILD_TYPE" "$IDF_VERSION"
+        ;;
     monitor)
         echo "Starting monitor on $BEST_PORT..."
         echo "Press Ctrl+] to exit monitor"
@@ -943,7 +1395,7 @@ case $OPERATION in
             echo "Monitor output will be logged to: $LOG_FILEPATH"
             echo "Note: Using tee to capture output (--log-file not available in this ESP-IDF version)"
             # Flash first, then monitor with logging
-            if ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" flash; then
+            if ! flash_firmware; then
                 echo "ERROR: Flash operation failed"
                 exit 1
             fi
@@ -953,10 +1405,65 @@ case $OPERATION in
                 exit 1
             fi
         else
-            if ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" flash monitor; then
+            if [ -f "$BUILD_DIR/build.ninja" ] && [ "$DIFF_FLASH" != "1" ] && [ "$AUTO_BAUD" != "1" ] && \
+                [ ${#FLASH_PARAM_ARGS[@]} -eq 0 ]; then
+                if ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" flash monitor; then
+                    echo "ERROR: Flash and monitor operation failed"
+                    exit 1
+                fi
+            elif ! flash_firmware || ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" monitor; then
+                echo "ERROR: Flash and monitor operation failed"
+                exit 1
+            fi
+        fi
+        ;;
+    flash_session)
+        # One serial session: flash with the esptool stub, switch the open port to the monitor
+        # baud rate and reset through it, so capture starts at the first ROM boot byte
+        echo "Flashing, resetting and monitoring $APP_TYPE app on $BEST_PORT in one serial session..."
+        session=(python3 "$SCRIPT_DIR/flash_session.py" "$BUILD_DIR" --port "$BEST_PORT" --chip "$IDF_TARGET"
+            --monitor-baud "$MONITORBAUD")
+        if [ "$SESSION_TIMESTAMPS" = "1" ]; then
+            session+=(--timestamps)
+        fi
+        if [ "$AUTO_BAUD" = "1" ] || [ ${#FLASH_PARAM_ARGS[@]} -gt 0 ]; then
+            # Baud negotiation and flash setting overrides need esptool: the session only resets
+            if ! flash_firmware; then
+                echo "ERROR: Flash operation failed"
+                exit 1
+            fi
+            session+=(--no-flash)
+        else
+            # idf.py flash builds first: so does the session
+            if [ -f "$BUILD_DIR/build.ninja" ] && ! run_idf_py -B "$BUILD_DIR" build; then
+                echo "ERROR: Build failed"
+                exit 1
+            fi
+            if [ "$DIFF_FLASH" = "1" ]; then
+                session+=(--diff)
+            fi
+        fi
+        SESSION_STATUS=0
+        if [ "$ENABLE_LOGGING" = true ]; then
+            echo "Session output will be logged to: $LOG_FILEPATH"
+            session+=(--report "${LOG_FILEPATH%.log}_boot.json")
+            "${session[@]}" 2>&1 | tee -a "$LOG_FILEPATH"
+            SESSION_STATUS=${PIPESTATUS[0]}
+        else
+            "${session[@]}" || SESSION_STATUS=$?
+        fi
+        if [ "$SESSION_STATUS" = "3" ]; then
+            echo "Serial session not possible: flashing and monitoring separately"
+            if ! flash_firmware || ! idf.py -B "$BUILD_DIR" -p "$BEST_PORT" monitor; then
                 echo "ERROR: Flash and monitor operation failed"
                 exit 1
             fi
+        elif [ "$SESSION_STATUS" = "130" ]; then
+            echo "Flash session interrupted"
+            exit 130
+        elif [ "$SESSION_STATUS" != "0" ]; then
+            echo "ERROR: Flash session failed"
+            exit 1
         fi
         ;;
     size)
@@ -972,24 +1479,15 @@ case $OPERATION in
             exit 1
         fi
         
-        # Show size information using idf.py
+        # Summary, component and symbol reports written by build_app.sh (cached by ELF hash,
+        # regenerated in one pass when the ELF changed since)
         echo "=== Firmware Size Analysis ==="
-        if ! idf.py -B "$BUILD_DIR" size; then
+        if ! python3 "$SCRIPT_DIR/size_report.py" "$BUILD_DIR" --project-name "$PROJECT_NAME" --print all; then
             echo "ERROR: Size analysis failed"
             exit 1
         fi
-        
         echo ""
-        echo "=== Component Size Breakdown ==="
-        if ! idf.py -B "$BUILD_DIR" size-components; then
-            echo "WARNING: Component size breakdown failed"
-        fi
-        
-        echo ""
-        echo "=== Memory Usage Summary ==="
-        if ! idf.py -B "$BUILD_DIR" size --format json | python3 -m json.tool 2>/dev/null | grep -E "(used|total|available)" || echo "JSON format not available"; then
-            echo "WARNING: Memory usage summary failed"
-        fi
+        echo "JSON reports: $BUILD_DIR/size_report.json, size_components.json, size_symbols.json"
         ;;
 esac
 
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Auto-baud support for flashing ESP32 devices.
+Identifies the USB-to-serial bridge behind a port (CP210x, CH340, FTDI, the
+chip's native USB-Serial-JTAG, ...) and keeps, per bridge, the highest baud
+rate that flashed successfully. flash_app.sh asks for the rates to try (the
+cached rate first, then the lower steps), flashes at the first one and steps
+down after a write error; a successful rate is recorded for the next run.
+"""
+
+import os
+import sys
+import json
+import time
+import argparse
+from pathlib import Path
+
+CACHE_FORMAT = 1
+DEFAULT_CACHE_FILE = Path.home() / ".cache" / "esp32-flash-baud.json"
+
+# Steps tried from the top (or from the cached rate) downwards
+AUTO_BAUD_RATES = [2000000, 1500000, 921600, 460800]
+
+# USB vendor:product IDs of the usual ESP32 serial bridges
+KNOWN_BRIDGES = {
+    "10c4:ea60": "CP210x",
+    "10c4:ea70": "CP2105",
+    "1a86:7523": "CH340",
+    "1a86:55d3": "CH343",
+    "1a86:55d4": "CH9102",
+    "0403:6001": "FT232R",
+    "0403:6010": "FT2232",
+    "0403:6014": "FT232H",
+    "0403:6015": "FT231X",
+    "303a:1001": "USB-Serial-JTAG",
+    "303a:0002": "USB-OTG CDC",
+}
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Flash Auto-Baud")
+    print("")
+    print("Usage: python3 flash_baud.py <command> <port> [rate]")
+    print("")
+    print("COMMANDS:")
+    print("  bridge <port>               - Print the USB bridge of a port (vendor:product and name)")
+    print("  rates <port>                - Print the baud rates to try, best first")
+    print("  record <port> <rate>        - Record a rate that flashed successfully")
+    print("  list                        - Print the cached rate of every bridge")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print(f"  --cache <file>              - Cache file (default: $ESP32_FLASH_BAUD_CACHE or {DEFAULT_CACHE_FILE})")
+    print("")
+    print("NEGOTIATION:")
+    print(f"  • Steps: {', '.join(str(r) for r in AUTO_BAUD_RATES)} baud")
+    print("  • Cached bridge: its recorded rate first, then the lower steps")
+    print("  • A failure after esptool changed the baud rate steps down; the rate that works is recorded")
+    print("  • Unknown bridges (no USB IDs, e.g. a plain UART) are never cached")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 flash_baud.py rates /dev/ttyUSB0")
+    print("  python3 flash_baud.py record /dev/ttyUSB0 921600")
+    print("")
+    print("For detailed information, see: docs/README_FLASH_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Pick and remember the fastest reliable flash baud rate per USB bridge",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("command", nargs="?", choices=["bridge", "rates", "record", "list"], help="Command")
+    parser.add_argument("port", nargs="?", help="Serial port")
+    parser.add_argument("rate", nargs="?", type=int, help="Baud rate that worked")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--cache", default=os.environ.get("ESP32_FLASH_BAUD_CACHE", str(DEFAULT_CACHE_FILE)),
+                        help="Cache file")
+
+    args = parser.parse_args()
+
+    if args.help or not args.command or (args.command != "list" and not args.port) \
+            or (args.command == "record" and not args.rate):
+        show_help()
+
+    return args
+
+def sysfs_usb_ids(port):
+    """USB vendor:product of a Linux tty from sysfs, None when not a USB device."""
+    device = Path("/sys/class/tty") / Path(port).name / "device"
+    try:
+        node = device.resolve()
+    except OSError:
+        return None
+    # The tty's device is the USB interface: idVendor/idProduct live on an ancestor
+    for parent in [node, *node.parents]:
+        vendor, product = parent / "idVendor", parent / "idProduct"
+        if vendor.exists() and product.exists():
+            return f"{vendor.read_text().strip()}:{product.read_text().strip()}".lower()
+    return None
+
+def usb_ids(port):
+    """USB vendor:product of a serial port (pyserial when available, sysfs otherwise)."""
+    real = os.path.realpath(port)
+    try:
+        from serial.tools import list_ports
+        for info in list_ports.comports():
+            if info.vid is not None and real in (info.device, os.path.realpath(info.device)):
+                return f"{info.vid:04x}:{info.pid:04x}"
+    except ImportError:
+        pass
+    return sysfs_usb_ids(real)
+
+def bridge_of(port):
+    """(key, name) of the port's bridge; key is None for unknown bridges."""
+    ids = usb_ids(port)
+    if not ids:
+        return None, "unknown"
+    return ids, KNOWN_BRIDGES.get(ids, "USB serial")
+
+def load_cache(path):
+    try:
+        with open(path) as f:
+            cache = json.load(f)
+        if cache.get('format') == CACHE_FORMAT:
+            return cache
+    except (OSError, ValueError):
+        pass
+    return {'format': CACHE_FORMAT, 'bridges': {}}
+
+def save_cache(path, cache):
+    path = Path(path)
+    path.parent.mkdir(parents=True, exist_ok=True)
+    tmp_path = path.with_name(path.name + f".{os.getpid()}")
+    with open(tmp_path, 'w') as f:
+        json.dump(cache, f, indent=2)
+        f.write("\n")
+    os.replace(tmp_path, path)
+
+def rates_to_try(cached):
+    """The cached rate first, then every lower step; all steps without a cached rate."""
+    if not cached:
+        return list(AUTO_BAUD_RATES)
+    return [cached] + [rate for rate in AUTO_BAUD_RATES if rate < cached]
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    cache = load_cache(args.cache)
+
+    if args.command == "list":
+        for key, entry in cache['bridges'].items():
+            print(f"{key}  {entry.get('name', ''):16} {entry.get('baud')}")
+        return
+
+    key, name = bridge_of(args.port)
+    entry = cache['bridges'].get(key, {}) if key else {}
+
+    if args.command == "bridge":
+        print(f"{key or '-'} {name}")
+    elif args.command == "rates":
+        cached = entry.get('baud')
+        source = f"cached {cached}" if cached else "not cached yet"
+        print(f"Auto baud: {name} bridge ({key or 'no USB IDs'}), {source}", file=sys.stderr)
+        print(" ".join(str(rate) for rate in rates_to_try(cached)))
+    elif args.command == "record":
+        if not key or entry.get('baud') == args.rate:
+            return
+        cache['bridges'][key] = {'name': name, 'baud': args.rate, 'updated': int(time.time())}
+        try:
+            save_cache(args.cache, cache)
+        except OSError as e:
+            print(f"Warning: cannot write {args.cache}: {e}", file=sys.stderr)
+
+if __name__ == '__main__':
+    main()
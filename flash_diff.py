@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+"""
+Differential flashing for ESP32 builds.
+Writes only what changed since the device was last flashed: images whose hash
+matches the device's manifest (keyed by MAC address) are confirmed with one
+on-chip MD5 and skipped, other images are compared against the chip block by
+block (64 KB, then 4 KB sectors) and only the differing sector runs are erased
+and written. flash_app.sh uses it for --diff and falls back to a full flash
+when it fails.
+"""
+
+import os
+import sys
+import json
+import time
+import zlib
+import hashlib
+import argparse
+from pathlib import Path
+
+MANIFEST_FORMAT = 1
+DEFAULT_MANIFEST_DIR = Path.home() / ".cache" / "esp32-flash-manifests"
+DEFAULT_BAUD = 460800
+ROM_BAUD = 115200
+
+SECTOR_SIZE = 0x1000        # Flash erase unit
+BLOCK_SIZE = 0x10000        # First comparison pass: one MD5 per 64 KB
+
+# Exit code when differential flashing cannot run here (no esptool, no device, no flash files)
+EXIT_UNAVAILABLE = 3
+
+class Unavailable(Exception):
+    """Differential flashing is not possible; the caller flashes in full instead."""
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Differential Flash")
+    print("")
+    print("Usage: python3 flash_diff.py <build_dir> --port <port> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --port <port>               - Serial port of the device")
+    print("  --chip <target>             - Expected chip (e.g. esp32c6); a different chip is an error")
+    print(f"  --baud <rate>               - Baud rate after connecting (default: $ESPBAUD or {DEFAULT_BAUD})")
+    print("  --app-only                  - Only the app image (bootloader and partition table untouched)")
+    print(f"  --manifest-dir <path>       - Manifest location (default: $ESP32_FLASH_MANIFEST_DIR or {DEFAULT_MANIFEST_DIR})")
+    print("  --dry-run                   - Compare and report, write nothing")
+    print("  --no-reset                  - Leave the chip in the bootloader (default: hard reset)")
+    print("")
+    print("PROCESS:")
+    print("  • Images: flash_files of flasher_args.json (or flash_args) in the build directory")
+    print("  • Device identity: MAC address read by esptool; manifest <mac>.json records the last image per offset")
+    print("  • Unchanged image (manifest hash): one on-chip MD5 confirms it, nothing is written")
+    print("  • Changed image: on-chip MD5 per 64 KB block, then per 4 KB sector inside differing blocks;")
+    print("    only the differing sector runs are written (compressed), then the whole image is verified")
+    print(f"  • Exit code {EXIT_UNAVAILABLE}: not possible here (no esptool, no connection); flash in full instead")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 flash_diff.py ../build-app-gpio_test-type-Debug-target-esp32c6-idf-release_v5_5 --port /dev/ttyACM0")
+    print("  python3 flash_diff.py <build_dir> --port /dev/ttyACM0 --app-only --dry-run")
+    print("")
+    print("For detailed information, see: docs/README_FLASH_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Flash only the changed regions of an ESP32 build",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_dir", nargs="?", help="Build directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--port", "-p", help="Serial port")
+    parser.add_argument("--chip", help="Expected chip")
+    parser.add_argument("--baud", "-b", type=int, default=int(os.environ.get("ESPBAUD", DEFAULT_BAUD)),
+                        help="Baud rate")
+    parser.add_argument("--app-only", action="store_true", help="Only the app image")
+    parser.add_argument("--manifest-dir", default=os.environ.get("ESP32_FLASH_MANIFEST_DIR", str(DEFAULT_MANIFEST_DIR)),
+                        help="Manifest location")
+    parser.add_argument("--dry-run", action="store_true", help="Write nothing")
+    parser.add_argument("--no-reset", action="store_true", help="No hard reset afterwards")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_dir or not args.port:
+        show_help()
+
+    return args
+
+def load_flash_images(build_dir, app_only):
+    """(offset, path) of every image to flash plus the flash settings, from the build directory."""
+    settings = {}
+    images = []
+    try:
+        with open(build_dir / "flasher_args.json") as f:
+            flasher_args = json.load(f)
+        settings = flasher_args.get('flash_settings', {})
+        if app_only:
+            app = flasher_args.get('app', {})
+            files = {app['offset']: app['file']} if app.get('file') else {}
+        else:
+            files = flasher_args.get('flash_files', {})
+        images = [(int(offset, 0), name) for offset, name in files.items()]
+    except (OSError, ValueError, KeyError):
+        # Builds without flasher_args.json: "--flash_mode dio ..." then "<offset> <file>" lines
+        try:
+            lines = (build_dir / ("flash_app_args" if app_only else "flash_args")).read_text().splitlines()
+        except OSError:
+            raise Unavailable(f"no flasher_args.json or flash_args in {build_dir}")
+        for line in lines:
+            fields = line.split()
+            if len(fields) == 2 and not fields[0].startswith("--"):
+                images.append((int(fields[0], 0), fields[1]))
+            elif "--flash_size" in fields:
+                settings['flash_size'] = fields[fields.index("--flash_size") + 1]
+    if not images:
+        raise Unavailable(f"no flash images listed in {build_dir}")
+    return sorted(images), settings
+
+def flash_size_bytes(size):
+    """"4MB" -> bytes; None for "keep"/"detect"."""
+    size = (size or "").upper()
+    if size.endswith("MB") and size[:-2].isdigit():
+        return int(size[:-2]) * 1024 * 1024
+    return None
+
+def connect(port, baud, chip):
+    """Open an esptool session with the flasher stub at the working baud rate."""
+    try:
+        from esptool.cmds import detect_chip
+    except ImportError:
+        raise Unavailable("esptool is not importable (source the ESP-IDF environment)")
+    try:
+        esp = detect_chip(port, ROM_BAUD, "default_reset")
+    except Exception as e:
+        raise Unavailable(f"cannot connect to {port}: {e}")
+
+    chip_name = esp.CHIP_NAME.lower().replace("-", "")
+    if chip and chip_name != chip.lower():
+        esp._port.close()
+        raise RuntimeError(f"device on {port} is {esp.CHIP_NAME}, the build is for {chip}")
+    esp = esp.run_stub()
+    if baud != ROM_BAUD:
+        esp.change_baud(baud)
+    return esp
+
+def device_mac(esp):
+    mac = esp.read_mac()
+    return ":".join(f"{b:02x}" for b in mac)
+
+def load_manifest(path):
+    try:
+        with open(path) as f:
+            manifest = json.load(f)
+        if manifest.get('format') == MANIFEST_FORMAT:
+            return manifest
+    except (OSError, ValueError):
+        pass
+    return None
+
+def differing_sectors(esp, offset, data):
+    """Sector offsets (relative to the image) whose on-chip MD5 differs from the image."""
+    sectors = []
+    for block in range(0, len(data), BLOCK_SIZE):
+        chunk = data[block:block + BLOCK_SIZE]
+        if esp.flash_md5sum(offset + block, len(chunk)) == hashlib.md5(chunk).hexdigest():
+            continue
+        for sector in range(block, block + len(chunk), SECTOR_SIZE):
+            part = data[sector:sector + SECTOR_SIZE]
+            if esp.flash_md5sum(offset + sector, len(part)) != hashlib.md5(part).hexdigest():
+                sectors.append(sector)
+    return sectors
+
+def sector_runs(sectors, size):
+    """Merge adjacent sectors into (start, end) runs within the image size."""
+    runs = []
+    for sector in sectors:
+        if runs and runs[-1][1] == sector:
+            runs[-1][1] = min(sector + SECTOR_SIZE, size)
+        else:
+            runs.append([sector, min(sector + SECTOR_SIZE, size)])
+    return runs
+
+def write_region(esp, offset, data):
+    """Erase and write one sector-aligned region (compressed transfer), then verify it."""
+    compressed = zlib.compress(data, 9)
+    esp.flash_defl_begin(len(data), len(compressed), offset)
+    for seq, start in enumerate(range(0, len(compressed), esp.FLASH_WRITE_SIZE)):
+        esp.flash_defl_block(compressed[start:start + esp.FLASH_WRITE_SIZE], seq)
+    # The stub acknowledges blocks before writing them: the MD5 also waits for the last write
+    if esp.flash_md5sum(offset, len(data)) != hashlib.md5(data).hexdigest():
+        raise RuntimeError(f"verification failed at 0x{offset:x}")
+
+def format_size(size):
+    if size >= 1024 * 1024:
+        return f"{size / (1024 * 1024):.1f} MB"
+    if size >= 1024:
+        return f"{size / 1024:.0f} KB"
+    return f"{size} bytes"
+
+def read_flash_images(build_dir, app_only):
+    """(offset, name, data) of every image to flash plus the flash settings."""
+    images, settings = load_flash_images(build_dir, app_only)
+    loaded = []
+    for offset, name in images:
+        try:
+            loaded.append((offset, name, (build_dir / name).read_bytes()))
+        except OSError as e:
+            raise Unavailable(f"cannot read {name}: {e}")
+    return loaded, settings
+
+def write_differences(esp, build_dir, loaded, settings, args):
+    """Compare every image with the chip over an open session and write the differences;
+    returns (bytes written, bytes compared). Updates the device's manifest."""
+    flash_size = flash_size_bytes(settings.get('flash_size'))
+    if flash_size:
+        esp.flash_set_parameters(flash_size)
+    mac = device_mac(esp)
+    manifest_path = Path(args.manifest_dir).expanduser() / f"{mac.replace(':', '')}.json"
+    manifest = load_manifest(manifest_path)
+    print(f"Device {mac} ({esp.CHIP_NAME}), manifest: {'found' if manifest else 'none (first differential flash)'}")
+    recorded = (manifest or {}).get('images', {})
+
+    written = 0
+    total = 0
+    new_images = dict(recorded)
+    for offset, name, data in loaded:
+        key = f"0x{offset:x}"
+        total += len(data)
+        digest = hashlib.sha256(data).hexdigest()
+        md5 = hashlib.md5(data).hexdigest()
+        label = f"  {key:<10}{name:<40}"
+        entry = {'file': name, 'size': len(data), 'sha256': digest, 'md5': md5}
+
+        # Manifest says unchanged: one MD5 over the image catches devices flashed by other tools
+        if recorded.get(key, {}).get('sha256') == digest and esp.flash_md5sum(offset, len(data)) == md5:
+            print(f"{label}unchanged")
+            new_images[key] = entry
+            continue
+
+        sectors = differing_sectors(esp, offset, data)
+        if not sectors:
+            print(f"{label}identical on chip")
+            new_images[key] = entry
+            continue
+        runs = sector_runs(sectors, len(data))
+        changed = sum(end - begin for begin, end in runs)
+        sector_count = (len(data) + SECTOR_SIZE - 1) // SECTOR_SIZE
+        if args.dry_run:
+            print(f"{label}{len(sectors)} of {sector_count} sectors differ ({format_size(changed)}, {len(runs)} runs)")
+            written += changed
+            continue
+        for begin, end in runs:
+            write_region(esp, offset + begin, data[begin:end])
+        if esp.flash_md5sum(offset, len(data)) != md5:
+            raise RuntimeError(f"{name}: image verification failed after writing")
+        print(f"{label}{len(sectors)} of {sector_count} sectors differ -> wrote {format_size(changed)} "
+              f"in {len(runs)} runs")
+        written += changed
+        new_images[key] = entry
+
+    if not args.dry_run:
+        # Images this build no longer flashes may overlap the new layout: forget them
+        current = {f"0x{offset:x}" for offset, _, _ in loaded}
+        if not args.app_only:
+            new_images = {key: value for key, value in new_images.items() if key in current}
+        manifest_path.parent.mkdir(parents=True, exist_ok=True)
+        manifest_path.write_text(json.dumps({
+            'format': MANIFEST_FORMAT,
+            'mac': mac,
+            'chip': esp.CHIP_NAME,
+            'updated': time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+            'build_dir': str(build_dir),
+            'images': new_images,
+        }, indent=2) + "\n")
+    return written, total
+
+def flash_differential(args):
+    """Compare every image with the chip and write the differences; returns bytes written."""
+    build_dir = Path(args.build_dir).resolve()
+    loaded, settings = read_flash_images(build_dir, args.app_only)
+
+    start = time.perf_counter()
+    esp = connect(args.port, args.baud, args.chip)
+    try:
+        written, total = write_differences(esp, build_dir, loaded, settings, args)
+        if not args.dry_run and not args.no_reset:
+            esp.hard_reset()
+    finally:
+        esp._port.close()
+
+    elapsed = time.perf_counter() - start
+    verb = "would write" if args.dry_run else "wrote"
+    print(f"Differential flash: {verb} {format_size(written)} of {format_size(total)} in {elapsed:.1f}s")
+    return written
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    try:
+        flash_differential(args)
+    except Unavailable as e:
+        print(f"Differential flash not possible: {e}", file=sys.stderr)
+        sys.exit(EXIT_UNAVAILABLE)
+    except Exception as e:
+        print(f"Error: Differential flash failed: {e}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+Fast path for flash-only runs on an existing build.
+Reads flasher_args.json from the build directory and runs esptool in-process
+with the chip, reset modes, stub setting, write_flash options and images it
+lists - the same command idf.py flash runs - without idf.py re-validating the
+CMake project first. A build older than any source of its components (the
+project's and external ones such as the wrapper library), sdkconfig*,
+app_config.yml or CMake files is not flashed: flash_app.sh then takes the
+normal path, which builds before flashing.
+"""
+
+import os
+import sys
+import json
+import argparse
+from pathlib import Path
+
+DEFAULT_BAUD = 460800       # idf.py flash default
+
+# Exit code when the fast path does not apply (stale or incomplete build, no device, no esptool)
+EXIT_UNAVAILABLE = 3
+
+# Project inputs whose change makes the build stale (besides sdkconfig.defaults* and every
+# component directory of project_description.json's build_component_paths)
+SOURCE_DIRS = ("main", "components")
+PROJECT_FILES = ("CMakeLists.txt", "sdkconfig", "partitions.csv", "app_config.yml")
+SKIP_DIRS = {".git", "__pycache__"}
+
+class Unavailable(Exception):
+    """The fast path does not apply; the caller flashes through idf.py instead."""
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Fast Flash")
+    print("")
+    print("Usage: python3 flash_fast.py <build_dir> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --port <port>               - Serial port (default: $ESPPORT; flash_app.sh passes the port it detected)")
+    print(f"  --baud <rate>               - Baud rate (default: $ESPBAUD or {DEFAULT_BAUD})")
+    print("  --project-dir <path>        - Project whose sources the build must be newer than")
+    print("                                (default: project_path of project_description.json)")
+    print("  --flash-mode <mode>         - Override the build's flash mode (flash_config.flash_mode)")
+    print("  --flash-freq <freq>         - Override the build's flash frequency (flash_config.flash_freq)")
+    print("  --flash-size <size>         - Override the build's flash size (flash_config.flash_size)")
+    print("  --print                     - Print the esptool command instead of running it")
+    print("")
+    print("PROCESS:")
+    print("  • esptool arguments: extra_esptool_args, write_flash_args and flash_files of flasher_args.json")
+    print("  • Freshness: every image must be newer than the sources of every non-ESP-IDF component")
+    print("    (build_component_paths), CMakeLists.txt, sdkconfig*, partitions.csv and app_config.yml")
+    print(f"  • Exit code {EXIT_UNAVAILABLE}: fast path not applicable (stale build, no device, no esptool)")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 flash_fast.py ../build-app-gpio_test-type-Release-target-esp32c6-idf-release_v5_5 --port /dev/ttyACM0")
+    print("  python3 flash_fast.py <build_dir> --print")
+    print("")
+    print("For detailed information, see: docs/README_FLASH_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Flash an up-to-date build with esptool, bypassing idf.py",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_dir", nargs="?", help="Build directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--port", "-p", default=os.environ.get("ESPPORT", ""), help="Serial port")
+    parser.add_argument("--baud", "-b", default=os.environ.get("ESPBAUD", ""), help="Baud rate")
+    parser.add_argument("--project-dir", help="Project directory")
+    parser.add_argument("--flash-mode", default="", help="Flash mode override")
+    parser.add_argument("--flash-freq", default="", help="Flash frequency override")
+    parser.add_argument("--flash-size", default="", help="Flash size override")
+    parser.add_argument("--print", action="store_true", help="Print the esptool command")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_dir:
+        show_help()
+
+    return args
+
+def load_flasher_args(build_dir):
+    try:
+        with open(build_dir / "flasher_args.json") as f:
+            return json.load(f)
+    except (OSError, ValueError) as e:
+        raise Unavailable(f"cannot read flasher_args.json: {e}")
+
+def load_project_description(build_dir):
+    try:
+        with open(build_dir / "project_description.json") as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+def component_dirs(project_dir, description):
+    """Project source directories plus the components the build pulled in from elsewhere
+    (EXTRA_COMPONENT_DIRS), as build_app.sh's watch mode collects them. ESP-IDF's own and
+    managed components change only with ESP-IDF or the dependency lock."""
+    dirs = [project_dir / d for d in SOURCE_DIRS]
+    idf_path = description.get('idf_path') or os.environ.get('IDF_PATH', '')
+    for path in description.get('build_component_paths', []):
+        path = Path(path)
+        if (idf_path and path.is_relative_to(idf_path)) or "managed_components" in path.parts:
+            continue
+        if not any(path.is_relative_to(known) for known in dirs):
+            dirs.append(path)
+    return dirs
+
+def newest_input(project_dir, source_dirs):
+    """(mtime, path) of the most recently modified project input."""
+    newest = (0.0, None)
+    names = list(PROJECT_FILES) + sorted(path.name for path in project_dir.glob("sdkconfig.defaults*"))
+    for name in names:
+        try:
+            newest = max(newest, (os.stat(project_dir / name).st_mtime, name))
+        except OSError:
+            pass
+    stack = list(source_dirs)
+    while stack:
+        try:
+            entries = os.scandir(stack.pop())
+        except OSError:
+            continue
+        with entries:
+            for entry in entries:
+                if entry.is_dir(follow_symlinks=False):
+                    if entry.name not in SKIP_DIRS and not entry.name.startswith("build"):
+                        stack.append(entry.path)
+                        # Added or removed files change the directory's mtime
+                        newest = max(newest, (entry.stat().st_mtime, entry.path))
+                elif entry.is_file():
+                    newest = max(newest, (entry.stat().st_mtime, entry.path))
+    return newest
+
+def check_fresh(build_dir, flasher_args, project_dir, source_dirs):
+    """Raise Unavailable unless every image exists and is newer than the project inputs."""
+    files = flasher_args.get('flash_files', {})
+    if not files:
+        raise Unavailable("no flash_files in flasher_args.json")
+    # Encrypted images need idf.py's encrypted-flash handling
+    if any(isinstance(section, dict) and str(section.get('encrypted', 'false')).lower() == 'true'
+           for section in flasher_args.values()):
+        raise Unavailable("build uses flash encryption")
+    try:
+        oldest_image = min(os.stat(build_dir / name).st_mtime for name in files.values())
+    except OSError as e:
+        raise Unavailable(f"missing image: {e.filename}")
+    if project_dir:
+        mtime, path = newest_input(project_dir, source_dirs)
+        if mtime > oldest_image:
+            raise Unavailable(f"build is older than {path}")
+
+def check_port(port):
+    """The port flash_app.sh detected (or $ESPPORT); no detection of its own, so both paths
+    always write to the same device."""
+    if not port:
+        raise Unavailable("no serial port given")
+    if not os.path.exists(port):
+        raise Unavailable(f"{port} does not exist")
+    # flash_app.sh fixes port permissions on its normal path
+    if not os.access(port, os.R_OK | os.W_OK):
+        raise Unavailable(f"no read/write access to {port}")
+    return port
+
+def esptool_command(flasher_args, port, baud, overrides):
+    """esptool argv equivalent to idf.py flash."""
+    extra = flasher_args.get('extra_esptool_args', {})
+    argv = ["--chip", extra.get('chip', 'auto'), "-p", port, "-b", str(baud),
+            "--before", extra.get('before', 'default_reset'), "--after", extra.get('after', 'hard_reset')]
+    if not extra.get('stub', True):
+        argv.append("--no-stub")
+    argv.append("write_flash")
+
+    write_flash_args = list(flasher_args.get('write_flash_args', []))
+    for option, value in overrides.items():
+        if not value:
+            continue
+        if option in write_flash_args:
+            write_flash_args[write_flash_args.index(option) + 1] = value
+        else:
+            write_flash_args += [option, value]
+    argv += write_flash_args
+    for offset, name in flasher_args['flash_files'].items():
+        argv += [offset, name]
+    return argv
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    build_dir = Path(args.build_dir).resolve()
+    try:
+        flasher_args = load_flasher_args(build_dir)
+        description = load_project_description(build_dir)
+        project_dir = args.project_dir or description.get('project_path')
+        project_dir = Path(project_dir).resolve() if project_dir else None
+        source_dirs = component_dirs(project_dir, description) if project_dir else []
+        check_fresh(build_dir, flasher_args, project_dir, source_dirs)
+        port = check_port(args.port)
+        argv = esptool_command(flasher_args, port, args.baud or DEFAULT_BAUD, {
+            "--flash_mode": args.flash_mode, "--flash_freq": args.flash_freq, "--flash_size": args.flash_size,
+        })
+        if args.print:
+            print("esptool.py " + " ".join(argv))
+            return
+        try:
+            import esptool
+        except ImportError:
+            raise Unavailable("esptool is not installed in this Python environment")
+    except Unavailable as e:
+        print(f"Fast flash not possible: {e}", file=sys.stderr)
+        sys.exit(EXIT_UNAVAILABLE)
+
+    # Image paths in flasher_args.json are relative to the build directory
+    os.chdir(build_dir)
+    print(f"Fast flash: esptool.py {' '.join(argv)}", flush=True)
+    try:
+        esptool.main(argv)
+    except Exception as e:
+        print(f"\nA fatal error occurred: {e}", file=sys.stderr)
+        sys.exit(2)
+
+if __name__ == '__main__':
+    main()
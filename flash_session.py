@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""
+Flash, reset and monitor an ESP32 over one serial session.
+Writes the build with the esptool flasher stub (in full, or only the changed
+sectors with --diff), then keeps the same port open: it switches to the monitor
+baud rate, hard resets the chip through that port and streams the output from
+the first ROM boot byte on, so no early boot line or panic is lost to a port
+reopen. Prints when the first byte, app_main and any panic arrived after reset.
+"""
+
+import os
+import re
+import sys
+import json
+import time
+import select
+import signal
+import argparse
+from types import SimpleNamespace
+from pathlib import Path
+
+from flash_diff import (DEFAULT_BAUD, DEFAULT_MANIFEST_DIR, EXIT_UNAVAILABLE, Unavailable, connect,
+                        format_size, read_flash_images, write_differences, write_region, flash_size_bytes)
+
+DEFAULT_MONITOR_BAUD = 115200
+EXIT_KEY = b"\x1d"              # Ctrl+], as in idf.py monitor
+
+# Boot milestones reported after reset (first match of each)
+MARKERS = {
+    'bootloader': re.compile(rb"ESP-IDF .* 2nd stage bootloader"),
+    'app_start': re.compile(rb"cpu_start: (?:Pro cpu start user code|Unicore app)"),
+    'app_main': re.compile(rb"Calling app_main\(\)"),
+}
+PANIC_RE = re.compile(rb"Guru Meditation Error|abort\(\) was called|Stack smashing protect failure|"
+                      rb"assert failed:|\*\*\*ERROR\*\*\* A stack overflow")
+
+# A native USB port vanishes while the chip resets: how long to wait for it to come back
+REOPEN_TIMEOUT = 5.0
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Flash and Monitor Session")
+    print("")
+    print("Usage: python3 flash_session.py <build_dir> --port <port> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --port <port>               - Serial port of the device")
+    print("  --chip <target>             - Expected chip (e.g. esp32c6); a different chip is an error")
+    print(f"  --baud <rate>               - Flash baud rate (default: $ESPBAUD or {DEFAULT_BAUD})")
+    print(f"  --monitor-baud <rate>       - Monitor baud rate (default: $MONITORBAUD or {DEFAULT_MONITOR_BAUD})")
+    print("  --diff                      - Write only the sectors that differ (see flash_diff.py)")
+    print("  --no-flash                  - Only reset and monitor (the build was flashed already)")
+    print("  --timestamps                - Prefix every line with the time since reset")
+    print("  --duration <seconds>        - Stop monitoring after this long (default: until Ctrl+])")
+    print("  --until <regex>             - Stop monitoring after the first line matching the expression")
+    print("  --report <file>             - Write the boot timing (first byte, milestones, panics) as JSON")
+    print("")
+    print("SESSION:")
+    print("  • Flash: stub at the flash baud rate, compressed writes, MD5 verification of every image")
+    print("  • Reset: the port switches to the monitor baud rate, then the chip is hard reset through it")
+    print("  • Capture starts before the reset: the ROM boot messages are the first bytes shown")
+    print("  • Native USB ports re-enumerate on reset and are reopened as soon as they reappear")
+    print("  • Ctrl+] exits; other keys are sent to the device")
+    print(f"  • Exit code {EXIT_UNAVAILABLE}: no session possible here (no esptool, no connection)")
+    print("  • Exit code 130: interrupted (Ctrl+C, SIGTERM) while connecting or flashing")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 flash_session.py ../build-app-gpio_test-type-Debug-target-esp32c6-idf-release_v5_5 --port /dev/ttyACM0")
+    print("  python3 flash_session.py <build_dir> --port /dev/ttyUSB0 --no-flash --until 'Calling app_main' --report boot.json")
+    print("")
+    print("For detailed information, see: docs/README_FLASH_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Flash, reset and monitor an ESP32 over one serial session",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_dir", nargs="?", help="Build directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--port", "-p", help="Serial port")
+    parser.add_argument("--chip", help="Expected chip")
+    parser.add_argument("--baud", "-b", type=int, default=int(os.environ.get("ESPBAUD") or DEFAULT_BAUD),
+                        help="Flash baud rate")
+    parser.add_argument("--monitor-baud", type=int,
+                        default=int(os.environ.get("MONITORBAUD") or DEFAULT_MONITOR_BAUD), help="Monitor baud rate")
+    parser.add_argument("--diff", action="store_true", help="Differential flash")
+    parser.add_argument("--no-flash", action="store_true", help="Only reset and monitor")
+    parser.add_argument("--timestamps", action="store_true", help="Prefix lines with the time since reset")
+    parser.add_argument("--duration", type=float, help="Monitoring time limit")
+    parser.add_argument("--until", help="Stop after a matching line")
+    parser.add_argument("--report", help="Boot timing report file")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_dir or not args.port:
+        show_help()
+
+    return args
+
+def flash_images(esp, build_dir, diff):
+    """Write the build over the open session (in full, or the differences only)."""
+    loaded, settings = read_flash_images(build_dir, False)
+    start = time.perf_counter()
+    if diff:
+        options = SimpleNamespace(manifest_dir=os.environ.get("ESP32_FLASH_MANIFEST_DIR", str(DEFAULT_MANIFEST_DIR)),
+                                  dry_run=False, app_only=False)
+        written, total = write_differences(esp, build_dir, loaded, settings, options)
+    else:
+        flash_size = flash_size_bytes(settings.get('flash_size'))
+        if flash_size:
+            esp.flash_set_parameters(flash_size)
+        written = total = 0
+        for offset, name, data in loaded:
+            write_region(esp, offset, data)
+            print(f"  0x{offset:<8x}{name:<40}{format_size(len(data))} written and verified")
+            written += len(data)
+            total += len(data)
+    print(f"Flash: wrote {format_size(written)} of {format_size(total)} in {time.perf_counter() - start:.1f}s")
+
+def reset_into_monitor(esp, monitor_baud):
+    """Hard reset the chip through the session's port, already at the monitor baud rate.
+    Returns the port and the reset time."""
+    port = esp._port
+    port.baudrate = monitor_baud
+    port.reset_input_buffer()
+    esp.hard_reset()
+    return port, time.perf_counter()
+
+def reopen(port):
+    """Reopen a port that disappeared (native USB re-enumerating after the reset)."""
+    deadline = time.perf_counter() + REOPEN_TIMEOUT
+    while time.perf_counter() < deadline:
+        try:
+            port.close()
+            port.open()
+            return True
+        except Exception:
+            time.sleep(0.02)
+    return False
+
+class BootLog:
+    """Splits the byte stream into lines and records boot milestones relative to the reset."""
+
+    def __init__(self, reset_at, timestamps, until):
+        self.reset_at = reset_at
+        self.timestamps = timestamps
+        self.until = re.compile(until.encode()) if until else None
+        self.first_byte_ms = None
+        self.markers = {}
+        self.panics = []
+        self.partial = b""
+        self.at_line_start = True
+        self.done = False
+
+    def elapsed_ms(self):
+        return round((time.perf_counter() - self.reset_at) * 1000, 1)
+
+    def feed(self, data):
+        """Print received bytes and inspect every completed line."""
+        now = self.elapsed_ms()
+        if self.first_byte_ms is None:
+            self.first_byte_ms = now
+        out = bytearray()
+        completed = []
+        for line in data.splitlines(keepends=True):
+            if self.timestamps and self.at_line_start:
+                out += f"[+{now / 1000:9.3f}s] ".encode()
+            out += line
+            self.at_line_start = line.endswith(b"\n")
+            self.partial += line
+            if self.at_line_start:
+                completed.append(self.partial)
+                self.partial = b""
+        sys.stdout.buffer.write(bytes(out))
+        sys.stdout.buffer.flush()
+        for line in completed:
+            self.inspect(line, now)
+
+    def inspect(self, line, now):
+        for name, pattern in MARKERS.items():
+            if name not in self.markers and pattern.search(line):
+                self.markers[name] = now
+        if PANIC_RE.search(line):
+            self.panics.append({'ms': now, 'line': line.decode(errors='replace').strip()})
+            print(f"\n[session] panic {now:.1f} ms after reset", file=sys.stderr)
+        if self.until and self.until.search(line):
+            self.done = True
+
+    def summary(self):
+        return {
+            'first_byte_ms': self.first_byte_ms,
+            'markers_ms': self.markers,
+            'panics': self.panics,
+        }
+
+def monitor(port, log, duration, interactive):
+    """Stream the port until Ctrl+], the duration or the --until line."""
+    port.timeout = 0.02
+    deadline = log.reset_at + duration if duration else None
+    stdin = sys.stdin.fileno()
+    while not log.done and (deadline is None or time.perf_counter() < deadline):
+        try:
+            data = port.read(port.in_waiting or 1)
+        except Exception:
+            if not reopen(port):
+                print("\n[session] port did not come back after the reset", file=sys.stderr)
+                return
+            print(f"\n[session] port reopened {log.elapsed_ms():.0f} ms after reset", file=sys.stderr)
+            continue
+        if data:
+            log.feed(data)
+        if interactive and select.select([stdin], [], [], 0)[0]:
+            keys = os.read(stdin, 64)
+            if EXIT_KEY in keys:
+                return
+            port.write(keys)
+
+def stop_monitoring(signum, frame):
+    raise KeyboardInterrupt
+
+def run_session(args):
+    build_dir = Path(args.build_dir).resolve()
+    # timeout(1) and CI runners stop the session with SIGTERM: end it like Ctrl+C, with the report
+    signal.signal(signal.SIGTERM, stop_monitoring)
+    esp = connect(args.port, args.baud, args.chip)
+    try:
+        if not args.no_flash:
+            flash_images(esp, build_dir, args.diff)
+        print(f"--- Reset, monitoring {args.port} at {args.monitor_baud} baud (Ctrl+] to exit) ---", flush=True)
+        port, reset_at = reset_into_monitor(esp, args.monitor_baud)
+        log = BootLog(reset_at, args.timestamps, args.until)
+
+        interactive = sys.stdin.isatty()
+        saved = None
+        if interactive:
+            import termios
+            import tty
+            saved = termios.tcgetattr(sys.stdin.fileno())
+            tty.setcbreak(sys.stdin.fileno())
+        try:
+            monitor(port, log, args.duration, interactive)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            if saved is not None:
+                termios.tcsetattr(sys.stdin.fileno(), termios.TCSADRAIN, saved)
+    finally:
+        esp._port.close()
+
+    result = log.summary()
+    timing = ["first byte " + ("none" if result['first_byte_ms'] is None else f"{result['first_byte_ms']:.1f} ms")]
+    timing += [f"{name} {ms:.1f} ms" for name, ms in result['markers_ms'].items()]
+    if result['panics']:
+        timing.append(f"{len(result['panics'])} panic(s)")
+    print(f"\n--- Boot timing after reset: {', '.join(timing)} ---", file=sys.stderr)
+    if args.report:
+        with open(args.report, 'w') as f:
+            json.dump({'port': args.port, 'monitor_baud': args.monitor_baud,
+                       'build_dir': str(build_dir), **result}, f, indent=2)
+            f.write("\n")
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    try:
+        run_session(args)
+    except Unavailable as e:
+        print(f"Serial session not possible: {e}", file=sys.stderr)
+        sys.exit(EXIT_UNAVAILABLE)
+    except KeyboardInterrupt:
+        # Ctrl+C or SIGTERM while connecting or flashing (monitoring ends normally on either)
+        print("\nFlash session interrupted", file=sys.stderr)
+        sys.exit(130)
+    except Exception as e:
+        print(f"Error: Flash session failed: {e}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -9,7 +9,8 @@ import sys
 import yaml
 import json
 import argparse
-from pathlib import Path
+
+from config_resolver import load_resolver
 
 def show_help():
     """Show comprehensive help information."""
@@ -20,11 +21,13 @@ def show_help():
     print("OPTIONS:")
     print("  --help, -h                  - Show this help message")
     print("  --output <file>             - Output to file instead of stdout")
-    print("  --format <format>           - Output format: json, yaml (default: json)")
+    print("  --format <format>           - Output format: json, yaml, tsv (default: json)")
     print("  --filter <app>              - Filter output for specific app only")
     print("  --verbose                   - Show detailed processing information")
     print("  --validate                  - Validate configuration before generating matrix")
     print("  --project-path <path>       - Path to project directory containing app_config.yml")
+    print("  --input <file>              - Re-emit an existing matrix file (JSON/YAML) instead of")
+    print("                                generating one; entries are validated against the config")
     print("")
     print("PURPOSE:")
     print("  Generate CI matrix from centralized configuration for GitHub Actions")
@@ -60,12 +63,16 @@ def show_help():
     print("  # Validate configuration")
     print("  python3 generate_matrix.py --validate")
     print("")
+    print("  # Build list consumed by build_app.sh --all / --matrix")
+    print("  python3 generate_matrix.py --format tsv --input matrix.json")
+    print("")
     print("  # Verbose output with validation")
     print("  python3 generate_matrix.py --verbose --validate --output matrix.json")
     print("")
     print("OUTPUT FORMAT:")
     print("  • JSON: Standard GitHub Actions matrix format")
     print("  • YAML: Alternative format for other CI systems")
+    print("  • TSV: app_name, build_type, idf_version, target per line (build_app.sh --all)")
     print("  • Structure: idf_version, build_type, app_name, target, config_source")
     print("")
     print("CONFIGURATION FILE:")
@@ -106,11 +113,12 @@ def parse_arguments():
     
     parser.add_argument("--help", "-h", action="store_true", help="Show help message")
     parser.add_argument("--output", "-o", help="Output file path")
-    parser.add_argument("--format", "-f", choices=["json", "yaml"], default="json", help="Output format")
+    parser.add_argument("--format", "-f", choices=["json", "yaml", "tsv"], default="json", help="Output format")
     parser.add_argument("--filter", help="Filter output for specific app")
     parser.add_argument("--verbose", "-v", action="store_true", help="Verbose output")
     parser.add_argument("--validate", action="store_true", help="Validate configuration")
     parser.add_argument("--project-path", "-p", help="Path to project directory containing app_config.yml")
+    parser.add_argument("--input", "-i", help="Existing matrix file to re-emit instead of generating one")
     
     args = parser.parse_args()
     
@@ -119,134 +127,39 @@ def parse_arguments():
     
     return args
 
-def load_config(project_path=None):
-    """Load the apps configuration file."""
-    if project_path:
-        # Use provided project path
-        project_dir = Path(project_path).resolve()
-        config_file = project_dir / "app_config.yml"
-        
-        if not config_file.exists():
-            print(f"Error: Configuration file not found: {config_file}", file=sys.stderr)
-            print(f"Please check the project path: {project_path}", file=sys.stderr)
-            sys.exit(1)
-    else:
-        # Try multiple possible paths for the configuration file
-        possible_paths = [
-            # When run from workspace root
-            Path("examples/esp32/app_config.yml"),
-            # When run from examples/esp32 directory
-            Path("app_config.yml"),
-            # When run from examples/esp32/scripts directory
-            Path("../app_config.yml"),
-            # When run from .github/workflows directory  
-            Path("../../examples/esp32/app_config.yml"),
-            # Absolute path calculation from script location
-            Path(__file__).resolve().parent.parent / "app_config.yml"
-        ]
-        
-        config_file = None
-        for path in possible_paths:
-            if path.exists():
-                config_file = path
-                break
-    
-    if not config_file:
-        print(f"Error: Configuration file not found in any of these locations:", file=sys.stderr)
-        for path in possible_paths:
-            print(f"  {path.resolve()}", file=sys.stderr)
-        sys.exit(1)
-    
-    try:
-        with open(config_file, 'r') as f:
-            return yaml.safe_load(f)
-    except Exception as e:
-        print(f"Error loading configuration: {e}", file=sys.stderr)
-        sys.exit(1)
-
-def generate_matrix(project_path=None):
+def generate_matrix(resolver):
     """Generate CI matrix from configuration with hierarchical overrides."""
-    config = load_config(project_path)
-    
-    # Global defaults from metadata
-    global_idf_versions = config['metadata'].get('idf_versions', ['release/v5.5'])
-    global_build_types_per_idf = config['metadata'].get('build_types', [['Debug', 'Release']])
-    
-    # Create a mapping from IDF version to its allowed build types
-    idf_to_build_types = {}
-    for i, idf_version in enumerate(global_idf_versions):
-        if i < len(global_build_types_per_idf):
-            idf_to_build_types[idf_version] = global_build_types_per_idf[i]
-        else:
-            # Fallback if no build types specified for this IDF version
-            idf_to_build_types[idf_version] = ['Debug', 'Release']
-    
-    # Optional excludes for special cases - handle None case
-    exclude_combinations = config.get('ci_config', {}).get('exclude_combinations', []) or []
+    # Override resolution (per-app IDF versions, nested/flat build types,
+    # per-app target) is shared with config_loader.sh via config_resolver.py
+    return { 'include': resolver.matrix_entries(ci_only=True) }
 
-    def is_excluded(entry: dict) -> bool:
-        for exc in exclude_combinations:
-            # If all keys in exc match the entry, then exclude
-            if all(k in entry and entry[k] == v for k, v in exc.items()):
-                return True
-        return False
+def load_matrix_file(resolver, matrix_file):
+    """Load a matrix file ({"include": [...]} or a plain list) and check every entry."""
+    with open(matrix_file) as f:
+        data = yaml.safe_load(f) or {}  # JSON is a subset of YAML
+    entries = data.get('include', []) if isinstance(data, dict) else data
+    if not isinstance(entries, list):
+        raise ValueError("expected {\"include\": [...]} or a list of entries")
 
-    # Build an explicit include list honoring per-app overrides
-    include: list[dict] = []
-    for app_name, app_config in config['apps'].items():
-        if not app_config.get('ci_enabled', True):
-            continue
-        
-        # Per-app overrides (app-specific settings take precedence)
-        per_app_idf_versions = app_config.get('idf_versions', global_idf_versions)
-        
-        # For each IDF version, determine the allowed build types
-        effective_combinations = []
-        for i, idf_version in enumerate(per_app_idf_versions):
-            if 'build_types' in app_config:
-                # App has specific build type requirements
-                app_build_types = app_config['build_types']
-                
-                # Check if build_types is nested (array of arrays) or flat (single array)
-                if isinstance(app_build_types[0], list):
-                    # Nested format: build_types: [["Debug", "Release"], ["Debug"]]
-                    if i < len(app_build_types):
-                        # Use the build types for this specific IDF version index
-                        for build_type in app_build_types[i]:
-                            effective_combinations.append((idf_version, build_type))
-                    else:
-                        # Fallback if no build types specified for this IDF version index
-                        for build_type in ['Debug', 'Release']:
-                            effective_combinations.append((idf_version, build_type))
-                else:
-                    # Flat format: build_types: ["Debug", "Release"] (same for all IDF versions)
-                    for build_type in app_build_types:
-                        effective_combinations.append((idf_version, build_type))
-            else:
-                # Use global IDF-specific build types
-                allowed_build_types = idf_to_build_types.get(idf_version, ['Debug', 'Release'])
-                for build_type in allowed_build_types:
-                    effective_combinations.append((idf_version, build_type))
-        
-        # Generate matrix entries for this app
-        for idf_version, build_type in effective_combinations:
-            # Create Docker-safe version for artifact naming (replace / with -)
-            docker_safe_version = idf_version.replace('/', '-')
-            # Create file-safe version for build directories (replace / and . with _)
-            file_safe_version = idf_version.replace('/', '_').replace('.', '_')
-            candidate = {
-                'idf_version': idf_version,  # Git format for ESP-IDF cloning
-                'idf_version_docker': docker_safe_version,  # Docker-safe format for artifacts
-                'idf_version_file': file_safe_version,  # File-safe format for build directories
-                'build_type': build_type,
-                'app_name': app_name,  # Use app_name for consistency
-                'target': config['metadata'].get('target', 'esp32c6'),  # Target from config
-                'config_source': 'app' if ('build_types' in app_config or 'idf_versions' in app_config) else 'global'
-            }
-            if not is_excluded(candidate):
-                include.append(candidate)
+    include = []
+    for i, entry in enumerate(entries):
+        if not isinstance(entry, dict) or not all(entry.get(k) for k in ('app_name', 'build_type', 'idf_version')):
+            raise ValueError(f"entry {i} needs app_name, build_type and idf_version")
+        app_name = entry['app_name']
+        if not resolver.has_app(app_name):
+            raise ValueError(f"entry {i}: unknown app '{app_name}'")
+        entry = dict(entry)
+        entry.setdefault('target', resolver.app(app_name)['target'])
+        if not resolver.is_valid_combination(app_name, entry['idf_version'], entry['build_type'], entry['target']):
+            raise ValueError(f"entry {i}: invalid combination {app_name} + {entry['build_type']} + "
+                             f"{entry['idf_version']} ({entry['target']})")
+        include.append(entry)
+    return {'include': include}
 
-    return { 'include': include }
+def format_tsv(matrix_config):
+    """One app_name/build_type/idf_version/target line per matrix entry."""
+    return "\n".join("\t".join(str(entry[k]) for k in ('app_name', 'build_type', 'idf_version', 'target'))
+                     for entry in matrix_config['include'])
 
 def validate_config(config):
     """Validate configuration structure and content."""
@@ -323,14 +236,15 @@ def main():
     args = parse_arguments()
 
     # Load configuration
-    config = load_config(args.project_path)
+    resolver = load_resolver(args.project_path)
+    config = resolver.config
     
     if args.verbose:
         print("Loading configuration...")
-        print(f"Config file: {Path(__file__).resolve().parent.parent / 'app_config.yml'}")
-        print(f"Apps found: {len(config['apps'])}")
-        print(f"Target: {config['metadata'].get('target', 'esp32c6')}")
-        print(f"IDF versions: {config['metadata'].get('idf_versions', ['release/v5.5'])}")
+        print(f"Config file: {resolver.config_file}")
+        print(f"Apps found: {len(resolver.apps)}")
+        print(f"Target: {resolver.metadata['target']}")
+        print(f"IDF versions: {resolver.idf_versions()}")
         print()
     
     # Validate configuration if requested
@@ -359,7 +273,14 @@ def main():
     if args.verbose:
         print("Generating CI matrix...")
     
-    matrix_config = generate_matrix(args.project_path)
+    if args.input:
+        try:
+            matrix_config = load_matrix_file(resolver, args.input)
+        except (OSError, ValueError, yaml.YAMLError) as e:
+            print(f"Error loading matrix file {args.input}: {e}", file=sys.stderr)
+            sys.exit(1)
+    else:
+        matrix_config = generate_matrix(resolver)
     
     if args.verbose:
         print(f"Matrix entries: {len(matrix_config['include'])}")
@@ -382,6 +303,8 @@ def main():
                 f.write(json.dumps(matrix_config, indent=2))
             elif args.format == 'yaml':
                 f.write(yaml.dump(matrix_config, indent=2))
+            elif args.format == 'tsv':
+                f.write(format_tsv(matrix_config) + "\n")
             print(f"Matrix written to {args.output}")
         return
     
@@ -390,6 +313,9 @@ def main():
         print(json.dumps(matrix_config))
     elif args.format == 'yaml':
         print(yaml.dump(matrix_config, indent=2))
+    elif args.format == 'tsv':
+        if matrix_config['include']:
+            print(format_tsv(matrix_config))
 
 if __name__ == '__main__':
     main()
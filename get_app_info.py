@@ -5,9 +5,11 @@ This script provides information about ESP32 apps from configuration
 """
 
 import sys
+import json
 import yaml
 import argparse
-from pathlib import Path
+
+from config_resolver import load_resolver
 
 def show_help():
     """Show comprehensive help information."""
@@ -118,49 +120,40 @@ def parse_arguments():
     
     return args
 
-def load_config(project_path=None):
-    """Load the apps configuration file."""
-    if project_path:
-        # Use provided project path
-        project_dir = Path(project_path).resolve()
-        config_file = project_dir / "app_config.yml"
-    else:
-        # Default behavior: assume script is in project/scripts/
-        config_file = Path(__file__).parent.parent / "app_config.yml"
-    
-    if not config_file.exists():
-        print(f"Error: Configuration file not found: {config_file}", file=sys.stderr)
-        if project_path:
-            print(f"Please check the project path: {project_path}", file=sys.stderr)
-        sys.exit(1)
-    
-    try:
-        with open(config_file, 'r') as f:
-            return yaml.safe_load(f)
-    except Exception as e:
-        print(f"Error loading configuration: {e}", file=sys.stderr)
-        sys.exit(1)
-
-def get_app_source_file(app_type):
+def get_app_source_file(resolver, app_type):
     """Get source file for an app type."""
-    config = load_config(project_path)
-    
-    if app_type not in config['apps']:
+    if not resolver.has_app(app_type):
         print(f"Error: Unknown app type: {app_type}", file=sys.stderr)
         sys.exit(1)
     
-    return config['apps'][app_type]['source_file']
+    return resolver.app(app_type)['source_file']
 
-def list_apps():
+def list_apps(resolver):
     """List all available apps."""
-    config = load_config(project_path)
-    apps = list(config['apps'].keys())
-    return apps
+    return resolver.app_names()
 
-def validate_app(app_type):
+def validate_app(resolver, app_type):
     """Validate if app type exists."""
-    config = load_config(project_path)
-    return app_type in config['apps']
+    return resolver.has_app(app_type)
+
+def print_structured(data, format_output):
+    """Print structured data in the requested format."""
+    if format_output == "json":
+        print(json.dumps(data, indent=2))
+    elif format_output == "yaml":
+        print(yaml.dump(data, indent=2, sort_keys=False), end="")
+    elif isinstance(data, list):
+        print(" ".join(data))
+    else:
+        for key, value in data.items():
+            if isinstance(value, dict):
+                print(f"{key}:")
+                for sub_key, sub_value in value.items():
+                    print(f"  {sub_key}: {' '.join(str(v) for v in sub_value)}")
+                continue
+            if isinstance(value, list):
+                value = " ".join(str(v) for v in value)
+            print(f"{key}: {value}")
 
 def main():
     """Main function."""
@@ -172,26 +165,47 @@ def main():
     format_output = args.format
     project_path = args.project_path
 
+    # Resolve the configuration once per invocation
+    resolver = load_resolver(project_path)
+
     if command == "source_file":
         if not app_type:
             print("Usage: get_app_info.py source_file <app_type>", file=sys.stderr)
             sys.exit(1)
-        source_file = get_app_source_file(app_type)
+        source_file = get_app_source_file(resolver, app_type)
         print(source_file)
     
     elif command == "list":
-        apps = list_apps()
-        print(" ".join(apps))
+        apps = list_apps(resolver)
+        if format_output == "text":
+            print(" ".join(apps))
+        else:
+            print_structured(apps, format_output)
     
     elif command == "validate":
         if not app_type:
             print("Usage: get_app_info.py validate <app_type>", file=sys.stderr)
             sys.exit(1)
-        is_valid = validate_app(app_type)
+        is_valid = validate_app(resolver, app_type)
         print("true" if is_valid else "false")
         if not is_valid:
             sys.exit(1)
     
+    elif command in ("info", "build_types", "idf_versions"):
+        if not app_type:
+            print(f"Usage: get_app_info.py {command} <app_type>", file=sys.stderr)
+            sys.exit(1)
+        if not resolver.has_app(app_type):
+            print(f"Error: Unknown app type: {app_type}", file=sys.stderr)
+            sys.exit(1)
+        app = resolver.app(app_type)
+        if command == "info":
+            info = {'app_type': app_type}
+            info.update({k: v for k, v in app.items() if k != 'valid_combinations'})
+            print_structured(info, format_output)
+        else:
+            print_structured(app[command], format_output)
+    
     else:
         print(f"Error: Unknown command: {command}", file=sys.stderr)
         sys.exit(1)
@@ -0,0 +1,427 @@
+#!/usr/bin/env python3
+"""
+Persistent idf.py command server for ESP32 builds.
+Every idf.py start re-imports the ESP-IDF Python tooling and re-runs the Python
+requirement check, which costs a second or more per command. This server loads
+idf.py once per ESP-IDF checkout and Python environment, runs the requirement
+check once, and listens on a Unix socket. Each command runs in a process forked
+from the warm server with the client's arguments, working directory, environment
+and stdin/stdout/stderr. The exit code is passed back to the client.
+Opt-in through IDF_SERVER=1 (run_idf_py in config_loader.sh).
+"""
+
+import os
+import sys
+import json
+import time
+import stat
+import array
+import fcntl
+import signal
+import socket
+import struct
+import hashlib
+import argparse
+import importlib.util
+import subprocess
+from pathlib import Path
+
+# Seconds without commands before the server exits
+DEFAULT_IDLE_TIMEOUT = 1800
+
+# Seconds a client waits for a freshly started server to listen
+STARTUP_TIMEOUT = 60
+
+# Exit code when the server cannot run the command (the client runs idf.py itself)
+EXIT_UNAVAILABLE = 125
+
+HEADER = struct.Struct("!I")
+
+class UnsafeServer(Exception):
+    """The socket directory or socket is not private to this user; idf.py runs directly."""
+
+def show_help():
+    """Show help information."""
+    print("ESP32 idf.py Command Server")
+    print("")
+    print("Usage: python3 idf_server.py <command> [OPTIONS] [-- idf.py arguments]")
+    print("")
+    print("COMMANDS:")
+    print("  run -- <args>               - Run idf.py <args> through the server (started on demand)")
+    print("  start                       - Start the server for $IDF_PATH in the background")
+    print("  stop                        - Stop the server for $IDF_PATH")
+    print("  status                      - Show whether the server for $IDF_PATH is running")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print(f"  --idle-timeout <seconds>    - Exit after this long without commands (default: {DEFAULT_IDLE_TIMEOUT})")
+    print("")
+    print("ENVIRONMENT VARIABLES:")
+    print("  IDF_PATH                    - ESP-IDF checkout (one server per checkout and Python environment)")
+    print("  IDF_SERVER                  - Set to 1 to route build_app.sh/flash_app.sh idf.py calls here")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 idf_server.py run -- -B build reconfigure")
+    print("  python3 idf_server.py status")
+    print("  IDF_SERVER=1 ./build_app.sh gpio_test Release")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments (idf.py arguments follow '--')."""
+    parser = argparse.ArgumentParser(
+        description="Persistent idf.py command server",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("command", nargs="?", choices=["run", "start", "stop", "status", "serve"])
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--idle-timeout", type=int, default=DEFAULT_IDLE_TIMEOUT,
+                        help="Seconds without commands before exiting")
+
+    argv = sys.argv[1:]
+    idf_args = []
+    if "--" in argv:
+        split = argv.index("--")
+        argv, idf_args = argv[:split], argv[split + 1:]
+    args = parser.parse_args(argv)
+    args.idf_args = idf_args
+
+    if args.help or not args.command:
+        show_help()
+
+    return args
+
+def server_paths():
+    """Socket and log path of the server for the current IDF_PATH and Python environment."""
+    idf_path = os.path.realpath(os.environ.get("IDF_PATH", ""))
+    identity = f"{idf_path}\n{os.environ.get('IDF_PYTHON_ENV_PATH', '')}"
+    runtime_dir = Path(os.environ.get("XDG_RUNTIME_DIR") or "/tmp") / f"esp32-idf-server-{os.getuid()}"
+    runtime_dir.mkdir(mode=0o700, exist_ok=True)
+    # In /tmp another user can create the directory first: the client passes its environment
+    # and terminal to whoever listens there, so only a private directory of our own is used
+    info = os.lstat(runtime_dir)
+    if not stat.S_ISDIR(info.st_mode) or info.st_uid != os.getuid() or info.st_mode & 0o077:
+        raise UnsafeServer(f"{runtime_dir} is not a private directory owned by this user")
+    name = hashlib.sha256(identity.encode()).hexdigest()[:16]
+    return runtime_dir / f"{name}.sock", runtime_dir / f"{name}.log"
+
+def server_lock(socket_path):
+    """Exclusive lock next to the socket that serializes server starts and binds (released on close)."""
+    lock = open(socket_path.with_suffix(".lock"), "a")
+    fcntl.flock(lock, fcntl.LOCK_EX)
+    return lock
+
+def server_python():
+    """Interpreter of the ESP-IDF Python environment (idf.py's dependencies live there)."""
+    env_path = os.environ.get("IDF_PYTHON_ENV_PATH")
+    if env_path and Path(env_path, "bin", "python").is_file():
+        return str(Path(env_path, "bin", "python"))
+    return sys.executable
+
+def stamp(idf_path):
+    """Modification times that invalidate a running server (ESP-IDF update, new Python environment)."""
+    paths = [Path(idf_path, "tools", "idf.py"), Path(idf_path, "tools", "requirements", "requirements.core.txt")]
+    if os.environ.get("IDF_PYTHON_ENV_PATH"):
+        paths.append(Path(os.environ["IDF_PYTHON_ENV_PATH"]))
+    return [path.stat().st_mtime if path.exists() else 0 for path in paths]
+
+def send_message(conn, payload, fds=()):
+    """Send a length-prefixed JSON message, optionally passing file descriptors."""
+    data = json.dumps(payload).encode()
+    ancillary = [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array("i", fds))] if fds else []
+    conn.sendmsg([HEADER.pack(len(data)), data], ancillary)
+
+def receive_message(conn, max_fds=0):
+    """Receive a length-prefixed JSON message and any passed file descriptors."""
+    fds = array.array("i")
+    data, ancillary, _, _ = conn.recvmsg(HEADER.size, socket.CMSG_LEN(max_fds * fds.itemsize) if max_fds else 0)
+    for level, kind, cmsg_data in ancillary:
+        if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+            fds.frombytes(cmsg_data[:len(cmsg_data) - (len(cmsg_data) % fds.itemsize)])
+    if len(data) < HEADER.size:
+        raise ConnectionError("connection closed")
+    remaining = HEADER.unpack(data)[0]
+    chunks = []
+    while remaining:
+        chunk = conn.recv(remaining)
+        if not chunk:
+            raise ConnectionError("connection closed")
+        chunks.append(chunk)
+        remaining -= len(chunk)
+    return json.loads(b"".join(chunks)), list(fds)
+
+# =============================================================================
+# SERVER
+# =============================================================================
+
+def load_idf_py(idf_path):
+    """Import idf.py once, run its environment check once and warm up the CLI extensions."""
+    spec = importlib.util.spec_from_file_location("idf_py_server_module", Path(idf_path, "tools", "idf.py"))
+    module = importlib.util.module_from_spec(spec)
+    sys.argv = ["idf.py"]
+    spec.loader.exec_module(module)
+
+    # The requirement check spawns idf_tools.py on every call; its result holds for the server's life
+    checks_output = module.check_environment()
+    module.check_environment = lambda: list(checks_output)
+
+    # Import the action extensions now instead of in every command
+    try:
+        module.init_cli(verbose_output=[])
+    except Exception as error:
+        print(f"Warm-up of idf.py extensions failed (loaded per command): {error}", file=sys.stderr)
+    return module
+
+def run_command(module, request, fds):
+    """Forked worker: adopt the client's process state and run idf.py main()."""
+    signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+    signal.signal(signal.SIGINT, signal.default_int_handler)
+    signal.signal(signal.SIGTERM, signal.SIG_DFL)
+    os.setpgid(0, 0)
+
+    sys.stdout.flush()
+    sys.stderr.flush()
+    for target, fd in enumerate(fds[:3]):
+        os.dup2(fd, target)
+        os.close(fd)
+    sys.stdout.reconfigure(line_buffering=True)
+    sys.stderr.reconfigure(line_buffering=True)
+
+    os.chdir(request['cwd'])
+    os.environ.clear()
+    os.environ.update(request['env'])
+    sys.argv = ["idf.py"] + request['argv']
+
+    try:
+        module.main()
+        code = 0
+    except SystemExit as exit_request:
+        if exit_request.code is None:
+            code = 0
+        elif isinstance(exit_request.code, int):
+            code = exit_request.code
+        else:
+            print(exit_request.code, file=sys.stderr)
+            code = 1
+    except KeyboardInterrupt:
+        code = 130
+    except BaseException as error:
+        print(f"idf.py failed in the command server: {error!r}", file=sys.stderr)
+        code = 1
+    sys.stdout.flush()
+    sys.stderr.flush()
+    return code
+
+def serve(args):
+    """Load idf.py and answer commands until idle for --idle-timeout seconds."""
+    idf_path = os.path.realpath(os.environ["IDF_PATH"])
+    socket_path, _ = server_paths()
+    started_stamp = stamp(idf_path)
+
+    # Bind before loading idf.py (clients queue meanwhile). Only a socket nobody accepts on is
+    # replaced: with concurrent starts the later server exits instead of orphaning the first.
+    with server_lock(socket_path):
+        conn = connect()
+        if conn:
+            conn.close()
+            print(f"idf.py server for {idf_path} already listening on {socket_path}", file=sys.stderr)
+            return
+        if socket_path.exists():
+            socket_path.unlink()
+        listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        listener.bind(str(socket_path))
+        listener.listen(16)
+    socket_inode = os.lstat(socket_path).st_ino
+
+    try:
+        signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+        module = load_idf_py(idf_path)
+        listener.settimeout(args.idle_timeout)
+        # Forked workers are reaped automatically
+        signal.signal(signal.SIGCHLD, signal.SIG_IGN)
+        print(f"idf.py server for {idf_path} listening on {socket_path}", file=sys.stderr, flush=True)
+
+        while True:
+            try:
+                conn, _ = listener.accept()
+            except socket.timeout:
+                break
+            with conn:
+                try:
+                    request, fds = receive_message(conn, max_fds=3)
+                except (OSError, ValueError, ConnectionError):
+                    continue
+                if request.get('command') == "stop":
+                    send_message(conn, {'status': "stopped"})
+                    break
+                if request.get('command') == "status":
+                    send_message(conn, {'status': "running", 'pid': os.getpid(), 'idf_path': idf_path})
+                    continue
+                if len(fds) != 3 or stamp(idf_path) != started_stamp:
+                    # ESP-IDF or its Python environment changed: let the client run idf.py and exit
+                    send_message(conn, {'status': "stale"})
+                    for fd in fds:
+                        os.close(fd)
+                    break
+
+                pid = os.fork()
+                if pid == 0:
+                    listener.close()
+                    code = EXIT_UNAVAILABLE
+                    try:
+                        send_message(conn, {'status': "running", 'pid': os.getpid()})
+                        code = run_command(module, request, fds)
+                        send_message(conn, {'status': "exited", 'code': code})
+                    finally:
+                        os._exit(code)
+                for fd in fds:
+                    os.close(fd)
+    finally:
+        listener.close()
+        # Leave a socket bound by a newer server alone
+        try:
+            if os.lstat(socket_path).st_ino == socket_inode:
+                socket_path.unlink()
+        except OSError:
+            pass
+
+# =============================================================================
+# CLIENT
+# =============================================================================
+
+def connect():
+    """Connect to the running server, or return None."""
+    socket_path, _ = server_paths()
+    try:
+        info = os.lstat(socket_path)
+    except OSError:
+        return None
+    if not stat.S_ISSOCK(info.st_mode) or info.st_uid != os.getuid():
+        raise UnsafeServer(f"{socket_path} is not a socket owned by this user")
+    conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        conn.connect(str(socket_path))
+    except OSError:
+        conn.close()
+        return None
+    return conn
+
+def start_server(idle_timeout):
+    """Start the server in its own session and wait until it listens."""
+    socket_path, log_path = server_paths()
+    # Concurrent clients (build_app.sh --all) start one server: a later client finds it listening,
+    # or its own server exits on finding another one listening
+    with server_lock(socket_path):
+        conn = connect()
+        if conn:
+            return conn
+        with open(log_path, "a") as log, open(os.devnull) as devnull:
+            process = subprocess.Popen([server_python(), os.path.abspath(__file__), "serve",
+                                        "--idle-timeout", str(idle_timeout)],
+                                       stdin=devnull, stdout=log, stderr=log, start_new_session=True)
+    deadline = time.monotonic() + STARTUP_TIMEOUT
+    while time.monotonic() < deadline:
+        exited = process.poll() is not None
+        conn = connect()
+        if conn:
+            return conn
+        if exited:
+            break
+        time.sleep(0.05)
+    print(f"WARNING: idf.py server did not start (see {log_path})", file=sys.stderr)
+    return None
+
+def run_idf_directly(idf_args):
+    """Fallback: replace this process with a normal idf.py run."""
+    sys.stdout.flush()
+    os.execvp("idf.py", ["idf.py"] + idf_args)
+
+def run(args):
+    """Run idf.py through the server, forwarding signals and passing back the exit code."""
+    if not os.environ.get("IDF_PATH") or not Path(os.environ["IDF_PATH"], "tools", "idf.py").is_file():
+        run_idf_directly(args.idf_args)
+
+    try:
+        conn = connect() or start_server(args.idle_timeout)
+    except (UnsafeServer, OSError) as error:
+        print(f"WARNING: idf.py server not used: {error}", file=sys.stderr)
+        conn = None
+    if not conn:
+        run_idf_directly(args.idf_args)
+
+    with conn:
+        send_message(conn, {'argv': args.idf_args, 'cwd': os.getcwd(), 'env': dict(os.environ)}, fds=[0, 1, 2])
+        try:
+            reply, _ = receive_message(conn)
+        except (OSError, ValueError, ConnectionError):
+            reply = {'status': "stale"}
+        if reply['status'] != "running":
+            run_idf_directly(args.idf_args)
+
+        # Ctrl+C and termination reach the command's process group, which lives in the server's session
+        worker_pid = reply['pid']
+        forwarded = []
+        def forward(signum, _frame):
+            forwarded.append(signum)
+            try:
+                os.killpg(worker_pid, signum)
+            except OSError:
+                pass
+        for signum in (signal.SIGINT, signal.SIGTERM, signal.SIGHUP):
+            signal.signal(signum, forward)
+
+        try:
+            reply, _ = receive_message(conn)
+        except (OSError, ValueError, ConnectionError):
+            if forwarded:
+                return 128 + forwarded[-1]
+            print("ERROR: idf.py server connection lost", file=sys.stderr)
+            return 1
+    return reply.get('code', 1)
+
+def control(command):
+    """Send stop/status to the server."""
+    conn = connect()
+    if not conn:
+        print(f"idf.py server for {os.environ.get('IDF_PATH', '(IDF_PATH not set)')} is not running")
+        return 1 if command == "status" else 0
+    with conn:
+        send_message(conn, {'command': command})
+        reply, _ = receive_message(conn)
+    if command == "status":
+        print(f"idf.py server for {reply['idf_path']} is running (pid {reply['pid']})")
+    else:
+        print("idf.py server stopped")
+    return 0
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    if args.command != "serve" and not os.environ.get("IDF_PATH"):
+        print("ERROR: IDF_PATH is not set (export the ESP-IDF environment first)", file=sys.stderr)
+        if args.command == "run":
+            run_idf_directly(args.idf_args)
+        sys.exit(1)
+
+    if args.command == "run":
+        sys.exit(run(args))
+    try:
+        if args.command == "serve":
+            serve(args)
+        elif args.command == "start":
+            conn = connect() or start_server(args.idle_timeout)
+            if conn:
+                conn.close()
+                sys.exit(control("status"))
+            sys.exit(1)
+        else:
+            sys.exit(control(args.command))
+    except UnsafeServer as error:
+        print(f"ERROR: {error}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
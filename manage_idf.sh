@@ -101,6 +101,7 @@ if [ "$1" = "--help" ] || [ "$1" = "-h" ]; then
     echo "  • IDF_PATH: Path to ESP-IDF installation"
     echo "  • IDF_VERSION: Current ESP-IDF version"
     echo "  • PATH: Updated with ESP-IDF tools"
+    echo "  • IDF_ENV_SNAPSHOT: Set to 0 to always source export.sh instead of the cached environment"
     echo ""
     echo "TROUBLESHOOTING:"
     echo "  • If installation fails: Check disk space, internet connection"
@@ -123,7 +124,9 @@ install_idf_versions() {
         return 1
     fi
     
-    local required_versions=$(get_idf_versions)
+    local IDF_VERSIONS=""
+    eval "$(config_query idf_versions)"
+    local required_versions="$IDF_VERSIONS"
     if [[ -z "$required_versions" ]]; then
         print_error "No ESP-IDF versions specified in configuration"
         return 1
@@ -191,6 +194,14 @@ export_idf_environment() {
         print_status "  IDF_PATH: $IDF_PATH"
         print_status "  IDF_VERSION: $IDF_VERSION"
         
+        # The snapshot lets other shells apply the same environment without export.sh
+        local snapshot_file
+        snapshot_file=$(idf_env_snapshot_file "$IDF_PATH")
+        if [[ -f "$snapshot_file" ]]; then
+            print_status "Environment snapshot: $snapshot_file"
+            print_status "  Apply in this shell: source $snapshot_file"
+        fi
+        
         # Show available commands
         if command_exists idf.py; then
             print_status "Available commands:"
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Precompiled-header generator for the HardFOC app and wrapper components.
+Scans each of the project's own components (main/, components/*/ and external
+component directories such as the wrapper library, never ESP-IDF or managed
+components) for unconditional #include lines in its translation units, picks
+the headers most of them share (FreeRTOS, drivers, esp_log, the wrapper's
+public headers, ...) and writes them into <component>.h, which
+cmake/precompiled_headers.cmake compiles for that component. A component's
+header only holds headers its own sources include, so it resolves with the
+component's include directories and REQUIRES. A header is rewritten only when
+its content changes, so an unchanged selection never invalidates the compiled PCH.
+"""
+
+import os
+import re
+import sys
+import json
+import argparse
+from collections import Counter
+from pathlib import Path
+
+DEFAULT_MIN_SHARE = 0.3     # Header must be included by at least 30% of the translation units
+DEFAULT_MAX_HEADERS = 16
+
+SOURCE_SUFFIXES = {".c", ".cpp", ".cc", ".cxx"}
+# Directories that never contain project translation units
+SKIP_DIRS = {".git", "managed_components", "test", "tests", "__pycache__"}
+
+INCLUDE_RE = re.compile(r'^\s*#\s*include\s*([<"])([^>"]+)[>"]')
+CONDITIONAL_OPEN_RE = re.compile(r'^\s*#\s*if(n?def)?\b')
+CONDITIONAL_CLOSE_RE = re.compile(r'^\s*#\s*endif\b')
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Precompiled Header Generator")
+    print("")
+    print("Usage: python3 pch_headers.py <project_dir> --output-dir <dir> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --output-dir <dir>          - Directory of the <component>.h headers (rewritten only when they change)")
+    print("  --project-description <f>   - project_description.json whose build_component_paths add the")
+    print("                                components from outside the project (EXTRA_COMPONENT_DIRS)")
+    print("  --key <text>                - Compatibility key recorded in the header (target, IDF, toolchain)")
+    print("  --min-share <ratio>         - Minimum share of translation units including a header (default: 0.3)")
+    print("  --max-headers <n>           - Maximum number of headers (default: 16)")
+    print("  --print                     - Print the selection with its include counts")
+    print("")
+    print("SELECTION:")
+    print("  • One header per component: main, components/*/ and external non-ESP-IDF components")
+    print("  • Translation units: the component's *.c/*.cpp/*.cc (no tests, no build trees)")
+    print("  • Only includes outside #if/#ifdef blocks count; headers of the including directory are skipped")
+    print("  • Ranked by the number of including units; ties keep the first-seen order")
+    print("  • Headers no C unit includes are guarded with __cplusplus, so C units can share the PCH")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 pch_headers.py .. --output-dir build/pch --print")
+    print("  python3 pch_headers.py .. --output-dir /tmp/pch --min-share 0.5 --max-headers 8")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Generate a precompiled header from the project's common includes",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("project_dir", nargs="?", help="Project directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--output-dir", "-o", help="Header directory")
+    parser.add_argument("--project-description", help="project_description.json of an earlier configure")
+    parser.add_argument("--key", default="", help="Compatibility key")
+    parser.add_argument("--min-share", type=float, default=DEFAULT_MIN_SHARE, help="Minimum include share")
+    parser.add_argument("--max-headers", type=int, default=DEFAULT_MAX_HEADERS, help="Maximum headers")
+    parser.add_argument("--print", action="store_true", help="Print the selection")
+
+    args = parser.parse_args()
+
+    if args.help or not args.project_dir or not args.output_dir:
+        show_help()
+
+    return args
+
+def component_dirs(project_dir, description_file):
+    """{component name: directory} of the project's own components. ESP-IDF names a component
+    after its directory; external ones come from an earlier configure's build_component_paths."""
+    dirs = {}
+    if (project_dir / "main").is_dir():
+        dirs["main"] = project_dir / "main"
+    components = project_dir / "components"
+    if components.is_dir():
+        for path in sorted(components.iterdir()):
+            if path.is_dir() and (path / "CMakeLists.txt").is_file():
+                dirs[path.name] = path
+    if description_file:
+        try:
+            with open(description_file) as f:
+                description = json.load(f)
+        except (OSError, ValueError):
+            description = {}
+        idf_path = description.get('idf_path') or os.environ.get('IDF_PATH', '')
+        for path in map(Path, description.get('build_component_paths', [])):
+            if (idf_path and path.is_relative_to(idf_path)) or "managed_components" in path.parts:
+                continue
+            if path.is_dir():
+                dirs.setdefault(path.name, path)
+    return dirs
+
+def translation_units(component_dir):
+    """Yield a component's own C/C++ sources."""
+    for dirpath, dirnames, filenames in os.walk(component_dir):
+        dirnames[:] = sorted(d for d in dirnames if d not in SKIP_DIRS and not d.startswith("build"))
+        for name in sorted(filenames):
+            if Path(name).suffix in SOURCE_SUFFIXES:
+                yield Path(dirpath) / name
+
+def unconditional_includes(source):
+    """Includes of one translation unit outside preprocessor conditionals."""
+    includes = []
+    depth = 0
+    try:
+        lines = source.read_text(errors="replace").splitlines()
+    except OSError:
+        return includes
+    for line in lines:
+        if CONDITIONAL_OPEN_RE.match(line):
+            depth += 1
+        elif CONDITIONAL_CLOSE_RE.match(line):
+            depth = max(depth - 1, 0)
+        elif depth == 0:
+            match = INCLUDE_RE.match(line)
+            if not match:
+                continue
+            kind, header = match.groups()
+            # Headers next to the source are private to it (and may depend on its macros)
+            if kind == '"' and (header.startswith(".") or (source.parent / header).exists()):
+                continue
+            includes.append(header)
+    return includes
+
+def select_headers(component_dir, min_share, max_headers):
+    """Rank shared headers; returns (selection, number of translation units).
+    The selection holds (header, include count, included by a C unit) tuples."""
+    counts = Counter()
+    first_seen = {}
+    c_headers = set()
+    units = 0
+    for source in translation_units(component_dir):
+        units += 1
+        for header in dict.fromkeys(unconditional_includes(source)):
+            counts[header] += 1
+            first_seen.setdefault(header, len(first_seen))
+            if source.suffix == ".c":
+                c_headers.add(header)
+    threshold = max(2, min_share * units)
+    ranked = sorted((h for h, n in counts.items() if n >= threshold),
+                    key=lambda h: (-counts[h], first_seen[h]))
+    return [(h, counts[h], h in c_headers) for h in ranked[:max_headers]], units
+
+def render_header(selection, key):
+    """Header text: headers C units use first, the C++-only ones behind __cplusplus."""
+    lines = [
+        "/* Generated by pch_headers.py - do not edit, build_app.sh regenerates it */",
+        f"/* Key: {key} */" if key else "/* Key: none */",
+        "#pragma once",
+        "",
+    ]
+    c_headers = [h for h, _, c in selection if c]
+    cxx_headers = [h for h, _, c in selection if not c]
+    lines += [f"#include <{h}>" for h in c_headers]
+    if cxx_headers:
+        lines += ["", "#ifdef __cplusplus"] + [f"#include <{h}>" for h in cxx_headers] + ["#endif"]
+    return "\n".join(lines) + "\n"
+
+def write_if_changed(output, content):
+    current = output.read_text() if output.exists() else None
+    if current != content:
+        output.parent.mkdir(parents=True, exist_ok=True)
+        output.write_text(content)
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+
+    project_dir = Path(args.project_dir).resolve()
+    output_dir = Path(args.output_dir)
+    written = 0
+    for name, directory in component_dirs(project_dir, args.project_description).items():
+        selection, units = select_headers(directory, args.min_share, args.max_headers)
+        output = output_dir / f"{name}.h"
+        # A component configured with a PCH keeps a header: emptied instead of removed
+        if not selection and not output.exists():
+            continue
+        try:
+            write_if_changed(output, render_header(selection, args.key))
+        except OSError as e:
+            print(f"Error writing {output}: {e}", file=sys.stderr)
+            sys.exit(1)
+        written += bool(selection)
+        if args.print:
+            print(f"{name}: {len(selection)} headers shared by {units} translation units")
+            for header, count, c in selection:
+                print(f"  {count:4d}  {header}{'' if c else '  (C++ only)'}")
+
+    if not written:
+        print("No component has headers shared by enough of its translation units", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -33,6 +33,8 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
     echo "  install_esp_idf             - Install ESP-IDF versions from configuration"
     echo "  export_esp_idf_version      - Export ESP-IDF environment for specific version"
     echo "  install_esp_idf_version     - Install specific ESP-IDF version"
+    echo "  apply_idf_env_snapshot      - Apply the cached environment of an ESP-IDF directory"
+    echo "  capture_idf_env_snapshot    - Source export.sh once and cache the environment it sets"
     echo "  list_esp_idf_versions       - List installed ESP-IDF versions"
     echo ""
     echo "  # Python dependency management"
@@ -84,6 +86,8 @@ if [[ "${BASH_SOURCE[0]}" == "${0}" ]] && ([ "$1" = "--help" ] || [ "$1" = "-h"
     echo "  • IDF_TARGET: Target MCU architecture"
     echo "  • PATH: Updated with ESP-IDF tools"
     echo "  • SETUP_MODE: local or ci for output formatting"
+    echo "  • IDF_ENV_SNAPSHOT: Set to 0 to always source export.sh (no environment snapshot)"
+    echo "  • IDF_ENV_SNAPSHOT_DIR: Snapshot location (default: ~/.cache/esp32-idf-env)"
     echo ""
     echo "FUNCTION CATEGORIES:"
     echo "  • System setup: OS detection, package installation"
@@ -555,7 +559,114 @@ install_esp_idf() {
     print_success "ESP-IDF versions installed/updated and optimized for caching"
 }
 
-# Function to export ESP-IDF environment for specific version
+# =============================================================================
+# ESP-IDF ENVIRONMENT SNAPSHOTS
+# =============================================================================
+
+# Sourcing export.sh takes seconds (Python venv checks, tool path resolution, git describe).
+# The environment it sets is captured once per ESP-IDF directory into a sourceable snapshot
+# and applied on later runs. The snapshot header holds a stamp of the checkout commit and the
+# tool/Python environment directories, so updating ESP-IDF or its tools regenerates it.
+# Set IDF_ENV_SNAPSHOT=0 to always source export.sh.
+
+# Function to print the snapshot file of an ESP-IDF directory
+idf_env_snapshot_file() {
+    local idf_dir="$1"
+    echo "${IDF_ENV_SNAPSHOT_DIR:-$HOME/.cache/esp32-idf-env}/${idf_dir//\//_}.sh"
+}
+
+# Function to print the validity stamp of an ESP-IDF directory (checkout commit + tool mtimes)
+idf_env_stamp() {
+    local idf_dir="$1"
+    local tools_path="${IDF_TOOLS_PATH:-$HOME/.espressif}"
+    local commit
+    commit=$(git -C "$idf_dir" rev-parse HEAD 2>/dev/null || echo "unknown")
+
+    local paths=() path
+    for path in "$tools_path" "$tools_path"/tools/*/ "$tools_path"/python_env/*/ "$idf_dir/export.sh"; do
+        if [[ -e "$path" ]]; then
+            paths+=("$path")
+        fi
+    done
+    local mtimes
+    mtimes=$(stat -c '%Y' "${paths[@]}" 2>/dev/null || stat -f '%m' "${paths[@]}" 2>/dev/null || echo "unknown")
+    echo "$idf_dir $commit ${mtimes//$'\n'/,}"
+}
+
+# Function to apply the environment snapshot of an ESP-IDF directory (fails when missing or stale)
+apply_idf_env_snapshot() {
+    local idf_dir="$1"
+    local snapshot_file
+    snapshot_file=$(idf_env_snapshot_file "$idf_dir")
+
+    if [[ "$IDF_ENV_SNAPSHOT" == "0" ]] || [[ ! -f "$snapshot_file" ]]; then
+        return 1
+    fi
+
+    local header
+    read -r header < "$snapshot_file"
+    if [[ "$header" != "# IDF_ENV_SNAPSHOT $(idf_env_stamp "$idf_dir")" ]]; then
+        return 1
+    fi
+
+    source "$snapshot_file"
+    command_exists idf.py
+}
+
+# Function to print the exported variables as sorted one-line assignments (name=%q), so two
+# dumps diff with comm (no associative arrays: setup_common.sh is also sourced by bash 3.2)
+idf_env_dump() {
+    local name
+    for name in $(compgen -e); do
+        printf '%s=%q\n' "$name" "${!name}"
+    done | LC_ALL=C sort
+}
+
+# Function to source export.sh of an ESP-IDF directory and save the environment it set
+capture_idf_env_snapshot() {
+    local idf_dir="$1"
+    local env_before path_before="$PATH"
+    env_before=$(idf_env_dump)
+
+    source "$idf_dir/export.sh"
+    if ! command_exists idf.py; then
+        return 1
+    fi
+    IDF_ENV_SNAPSHOT_DESCRIBE=$(idf.py --version 2>/dev/null | head -1 || echo "Unknown")
+
+    if [[ "$IDF_ENV_SNAPSHOT" == "0" ]]; then
+        return 0
+    fi
+
+    local snapshot_file
+    snapshot_file=$(idf_env_snapshot_file "$idf_dir")
+    if ! mkdir -p "$(dirname "$snapshot_file")"; then
+        print_warning "Could not create the ESP-IDF environment snapshot directory"
+        return 0
+    fi
+
+    # Only variables export.sh added or changed; PATH keeps the caller's PATH after the ESP-IDF entries
+    local line name
+    {
+        echo "# IDF_ENV_SNAPSHOT $(idf_env_stamp "$idf_dir")"
+        echo "# Environment set by $idf_dir/export.sh (regenerated when the checkout or tools change)"
+        while IFS= read -r line; do
+            name="${line%%=*}"
+            case "$name" in
+                _|PWD|OLDPWD|SHLVL) continue ;;
+            esac
+            if [[ "$name" == "PATH" ]] && [[ -n "$path_before" ]] && [[ "$PATH" == *":$path_before" ]]; then
+                printf 'export PATH=%q"$PATH"\n' "${PATH%"$path_before"}"
+            else
+                echo "export $line"
+            fi
+        done < <(LC_ALL=C comm -13 <(echo "$env_before") <(idf_env_dump))
+        printf 'IDF_ENV_SNAPSHOT_DESCRIBE=%q\n' "$IDF_ENV_SNAPSHOT_DESCRIBE"
+    } > "$snapshot_file.$$" && mv "$snapshot_file.$$" "$snapshot_file" || print_warning "Could not write ESP-IDF environment snapshot $snapshot_file"
+    return 0
+}
+
+# Function to export ESP-IDF environment for a specific version (snapshot when current, else export.sh)
 export_esp_idf_version() {
     local idf_version="$1"
     local auto_install="${2:-false}"
@@ -593,14 +704,19 @@ export_esp_idf_version() {
     
     print_status "Exporting ESP-IDF environment for version: $idf_version"
     
-    # Source the ESP-IDF export script
+    # Apply the cached environment of this checkout while it is current
+    if apply_idf_env_snapshot "$idf_dir"; then
+        print_success "ESP-IDF environment loaded from snapshot: $IDF_ENV_SNAPSHOT_DESCRIBE"
+        export IDF_PATH="$idf_dir"
+        export IDF_VERSION="$idf_version"
+        return 0
+    fi
+    
+    # Source the ESP-IDF export script (and snapshot the environment it sets)
     if [[ -f "$idf_dir/export.sh" ]]; then
-        source "$idf_dir/export.sh"
-        
         # Verify the environment is loaded
-        if command_exists idf.py; then
-            local idf_path=$(idf.py --version 2>/dev/null | head -1 || echo "Unknown")
-            print_success "ESP-IDF environment loaded: $idf_path"
+        if capture_idf_env_snapshot "$idf_dir"; then
+            print_success "ESP-IDF environment loaded: $IDF_ENV_SNAPSHOT_DESCRIBE"
             
             # Export IDF_PATH for this session
             export IDF_PATH="$idf_dir"
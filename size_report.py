@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+"""
+Single-pass firmware size analysis for ESP32 builds.
+This script parses the linker map file once and writes the summary, per-component
+and per-symbol reports (text and JSON) into the build directory. The reports are
+cached by the SHA-256 of the ELF file, so repeated calls only read them back.
+Used by build_app.sh after every build and by flash_app.sh size.
+"""
+
+import re
+import sys
+import json
+import hashlib
+import argparse
+from pathlib import Path
+
+# Bump when the layout of the generated reports changes
+REPORT_FORMAT = 2
+
+# Report files written into the build directory
+CACHE_NAME = "size.cache"
+REPORT_FILES = {
+    'summary_text': "size.txt",
+    'summary_json': "size_report.json",
+    'components_text': "size_components.txt",
+    'components_json': "size_components.json",
+    'symbols_text': "size_symbols.txt",
+    'symbols_json': "size_symbols.json",
+}
+
+# Which reports --print shows
+PRINT_CHOICES = {
+    'summary': ['summary_text'],
+    'components': ['components_text'],
+    'symbols': ['symbols_text'],
+    'all': ['summary_text', 'components_text', 'symbols_text'],
+    'none': [],
+}
+
+DEFAULT_TOP = 30
+
+MEMORY_RE = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+ADDR_SIZE_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.*))?$')
+OUTPUT_SECTION_RE = re.compile(r'^(\.\S+|[A-Za-z_]\S*)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+INPUT_SECTION_RE = re.compile(r'^ (\.\S+|COMMON)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(.*))?$')
+SYMBOL_RE = re.compile(r'^\s+0x[0-9a-fA-F]+\s+([A-Za-z_.$][\w.$@]*)$')
+ARCHIVE_RE = re.compile(r'([^/\\]+\.a)\(([^)]+)\)$')
+
+def show_help():
+    """Show help information."""
+    print("ESP32 Firmware Size Report")
+    print("")
+    print("Usage: python3 size_report.py <build_dir> [OPTIONS]")
+    print("")
+    print("OPTIONS:")
+    print("  --help, -h                  - Show this help message")
+    print("  --project-name <name>       - Project name (<name>.elf/.map), default: the only ELF in build_dir")
+    print("  --print <report>            - Print summary, components, symbols, all or none (default: summary)")
+    print("  --top <n>                   - Rows in the component and symbol text reports (default: 30)")
+    print("  --force                     - Re-analyze even when the cached reports match the ELF")
+    print("")
+    print("OUTPUT FILES (in build_dir):")
+    for name in REPORT_FILES.values():
+        print(f"  • {name}")
+    print(f"  • {CACHE_NAME}: ELF SHA-256 the reports were generated from")
+    print("")
+    print("EXAMPLES:")
+    print("  python3 size_report.py ../build-app-gpio_test-type-Release-target-esp32c6-idf-release_v5_5")
+    print("  python3 size_report.py <build_dir> --print all --top 10")
+    print("")
+    print("For detailed information, see: docs/README_BUILD_SYSTEM.md")
+    sys.exit(0)
+
+def parse_arguments():
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Single-pass firmware size analysis",
+        add_help=False  # We'll handle help manually
+    )
+
+    parser.add_argument("build_dir", nargs="?", help="Build directory")
+    parser.add_argument("--help", "-h", action="store_true", help="Show help message")
+    parser.add_argument("--project-name", help="Project name")
+    parser.add_argument("--print", dest="print_report", choices=list(PRINT_CHOICES), default="summary",
+                        help="Report to print")
+    parser.add_argument("--top", type=int, default=DEFAULT_TOP, help="Rows in the text reports")
+    parser.add_argument("--force", action="store_true", help="Ignore cached reports")
+
+    args = parser.parse_args()
+
+    if args.help or not args.build_dir:
+        show_help()
+
+    return args
+
+def find_build_outputs(build_dir, project_name=None):
+    """Return the (elf, map) paths of a build directory."""
+    if project_name:
+        elf_file = build_dir / f"{project_name}.elf"
+    else:
+        elf_files = sorted(build_dir.glob("*.elf"))
+        if len(elf_files) != 1:
+            raise FileNotFoundError(f"Expected one ELF file in {build_dir}, found {len(elf_files)}")
+        elf_file = elf_files[0]
+    map_file = elf_file.with_suffix(".map")
+    for path in (elf_file, map_file):
+        if not path.is_file():
+            raise FileNotFoundError(f"Build output not found: {path}")
+    return elf_file, map_file
+
+def file_sha256(path):
+    """SHA-256 of a file, read in chunks."""
+    digest = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+def component_name(source):
+    """Component (archive) an input section comes from, e.g. libfreertos.a."""
+    if not source:
+        return "(linker)"
+    match = ARCHIVE_RE.search(source)
+    if match:
+        return match.group(1)
+    return Path(source).name
+
+def parse_map_file(map_file):
+    """Parse a GNU ld map file into memory regions, output sections and input sections."""
+    regions = []
+    sections = []
+    inputs = []
+
+    state = None
+    pending_output = None
+    pending_input = None
+    current_output = None
+    last_input = None
+
+    with open(map_file, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+
+            if line.startswith("Memory Configuration"):
+                state = 'memory'
+                continue
+            if line.startswith("Linker script and memory map"):
+                state = 'map'
+                continue
+
+            if state == 'memory':
+                match = MEMORY_RE.match(line)
+                if match and match.group(1) != '*default*':
+                    regions.append({
+                        'name': match.group(1),
+                        'origin': int(match.group(2), 16),
+                        'length': int(match.group(3), 16),
+                    })
+                continue
+
+            if state != 'map' or not line:
+                continue
+
+            # Long section names wrap: the address and size follow on the next line
+            if pending_output is not None or pending_input is not None:
+                match = ADDR_SIZE_RE.match(line)
+                if match:
+                    address, size = int(match.group(1), 16), int(match.group(2), 16)
+                    if pending_output is not None:
+                        current_output = {'name': pending_output, 'address': address, 'size': size}
+                        sections.append(current_output)
+                        last_input = None
+                    else:
+                        last_input = add_input(inputs, current_output, pending_input, address, size, match.group(3))
+                    pending_output = pending_input = None
+                    continue
+                pending_output = pending_input = None
+
+            if not line[0].isspace():
+                match = OUTPUT_SECTION_RE.match(line)
+                if match:
+                    current_output = {'name': match.group(1), 'address': int(match.group(2), 16),
+                                      'size': int(match.group(3), 16)}
+                    sections.append(current_output)
+                    last_input = None
+                elif line.startswith('.') and ' ' not in line:
+                    pending_output = line
+                else:
+                    current_output = None  # /DISCARD/, LOAD, OUTPUT(...) and friends
+                continue
+
+            if current_output is None:
+                continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if match:
+                last_input = add_input(inputs, current_output, match.group(1), int(match.group(2), 16),
+                                       int(match.group(3), 16), match.group(4))
+                continue
+
+            stripped = line.strip()
+            if line.startswith(' .') and ' ' not in stripped:
+                pending_input = stripped
+                continue
+
+            # First symbol defined in an input section names it in the symbol report
+            match = SYMBOL_RE.match(line)
+            if match and last_input is not None and last_input['symbol'] is None:
+                last_input['symbol'] = match.group(1)
+
+    return regions, sections, inputs
+
+def add_input(inputs, output_section, name, address, size, source):
+    """Record an input section (zero-sized sections are skipped)."""
+    if size == 0:
+        return None
+    entry = {
+        'section': name,
+        'output_section': output_section['name'],
+        'address': address,
+        'size': size,
+        'component': component_name(source.strip() if source else ''),
+        'object': source.strip() if source else '',
+        'symbol': None,
+    }
+    inputs.append(entry)
+    return entry
+
+# Region name hints for output sections when regions overlap (e.g. irom/drom, unified SRAM)
+REGION_HINTS = (
+    (('rodata', 'appdesc'), ('drom', 'rodata')),
+    (('flash.text',), ('irom', 'code')),
+    (('iram',), ('iram',)),
+    (('dram', 'bss', 'data', 'noinit'), ('dram',)),
+)
+
+def region_for(regions, section_name, address):
+    """Memory region of an output section (None for non-allocated sections)."""
+    candidates = [region['name'] for region in regions
+                  if region['origin'] <= address < region['origin'] + region['length']]
+    if len(candidates) > 1:
+        for section_hints, region_hints in REGION_HINTS:
+            if any(hint in section_name for hint in section_hints):
+                for candidate in candidates:
+                    if any(hint in candidate for hint in region_hints):
+                        return candidate
+    return candidates[0] if candidates else None
+
+def analyze(elf_file, map_file):
+    """Build the complete size report from one pass over the map file."""
+    regions, sections, inputs = parse_map_file(map_file)
+
+    section_region = {}
+    memory = {region['name']: {'used': 0, 'total': region['length']} for region in regions}
+    output_sections = []
+    for section in sections:
+        region = region_for(regions, section['name'], section['address'])
+        if region is None or section['size'] == 0:
+            continue
+        section_region[section['name']] = region
+        memory[region]['used'] += section['size']
+        output_sections.append({'name': section['name'], 'address': section['address'],
+                                'size': section['size'], 'region': region})
+
+    components = {}
+    symbols = []
+    for entry in inputs:
+        region = section_region.get(entry['output_section'])
+        if region is None:
+            continue
+        component = components.setdefault(entry['component'], {'total': 0, 'regions': {}, 'sections': {}})
+        component['total'] += entry['size']
+        component['regions'][region] = component['regions'].get(region, 0) + entry['size']
+        component['sections'][entry['output_section']] = \
+            component['sections'].get(entry['output_section'], 0) + entry['size']
+
+        name = entry['symbol'] or entry['section']
+        symbols.append({'name': name, 'size': entry['size'], 'component': entry['component'],
+                        'section': entry['output_section'], 'region': region, 'object': entry['object']})
+
+    for usage in memory.values():
+        usage['free'] = usage['total'] - usage['used']
+        usage['used_percent'] = round(100.0 * usage['used'] / usage['total'], 2) if usage['total'] else 0.0
+
+    bin_file = elf_file.with_suffix(".bin")
+    return {
+        'elf': str(elf_file),
+        'map': str(map_file),
+        'image_size': bin_file.stat().st_size if bin_file.is_file() else None,
+        'memory': {name: usage for name, usage in memory.items() if usage['used']},
+        'sections': output_sections,
+        'components': dict(sorted(components.items(), key=lambda item: -item[1]['total'])),
+        'symbols': sorted(symbols, key=lambda s: -s['size']),
+    }
+
+def format_summary(report):
+    """Memory usage per region and output section."""
+    lines = [f"=== Memory Usage ({Path(report['elf']).name}) ==="]
+    lines.append(f"{'Region':<24}{'Used':>12}{'Total':>12}{'Free':>12}{'Used %':>9}")
+    for name, usage in report['memory'].items():
+        lines.append(f"{name:<24}{usage['used']:>12,}{usage['total']:>12,}{usage['free']:>12,}"
+                     f"{usage['used_percent']:>8.1f}%")
+    if report['image_size'] is not None:
+        lines.append(f"Total image size: {report['image_size']:,} bytes")
+    lines.append("")
+    lines.append("=== Output Sections ===")
+    lines.append(f"{'Section':<32}{'Address':>12}{'Size':>12}  Region")
+    for section in report['sections']:
+        lines.append(f"{section['name']:<32}{section['address']:>#12x}{section['size']:>12,}  {section['region']}")
+    return "\n".join(lines) + "\n"
+
+def format_components(report, top):
+    """Per-component (archive) sizes split by memory region."""
+    regions = list(report['memory'])
+    lines = [f"=== Component Sizes (top {top} of {len(report['components'])}) ==="]
+    lines.append(f"{'Component':<32}{'Total':>10}" + "".join(f"{name:>16}" for name in regions))
+    for name, component in list(report['components'].items())[:top]:
+        lines.append(f"{name:<32}{component['total']:>10,}" +
+                     "".join(f"{component['regions'].get(region, 0):>16,}" for region in regions))
+    return "\n".join(lines) + "\n"
+
+def format_symbols(report, top):
+    """Largest input sections, named after the first symbol they define."""
+    lines = [f"=== Largest Symbols (top {top} of {len(report['symbols'])}) ==="]
+    lines.append(f"{'Symbol':<48}{'Size':>10}  {'Component':<28}Section")
+    for symbol in report['symbols'][:top]:
+        lines.append(f"{symbol['name'][:47]:<48}{symbol['size']:>10,}  {symbol['component'][:27]:<28}{symbol['section']}")
+    return "\n".join(lines) + "\n"
+
+def read_cache(build_dir, elf_hash, top):
+    """True when every report exists and was generated from this ELF (and row count)."""
+    cache_file = build_dir / CACHE_NAME
+    try:
+        cached = cache_file.read_text().split()
+    except OSError:
+        return False
+    if cached != [str(REPORT_FORMAT), elf_hash, str(top)]:
+        return False
+    return all((build_dir / name).is_file() for name in REPORT_FILES.values())
+
+def write_reports(build_dir, report, elf_hash, top):
+    """Write all report files, then the cache stamp."""
+    summary = {key: report[key] for key in ('elf', 'map', 'image_size', 'memory', 'sections')}
+    outputs = {
+        'summary_text': format_summary(report),
+        'summary_json': json.dumps(summary, indent=2) + "\n",
+        'components_text': format_components(report, top),
+        'components_json': json.dumps(report['components'], indent=2) + "\n",
+        'symbols_text': format_symbols(report, top),
+        'symbols_json': json.dumps(report['symbols'], indent=2) + "\n",
+    }
+    for key, content in outputs.items():
+        (build_dir / REPORT_FILES[key]).write_text(content)
+    (build_dir / CACHE_NAME).write_text(f"{REPORT_FORMAT} {elf_hash} {top}\n")
+
+def main():
+    """Main function."""
+    args = parse_arguments()
+    build_dir = Path(args.build_dir).resolve()
+
+    try:
+        elf_file, map_file = find_build_outputs(build_dir, args.project_name)
+        elf_hash = file_sha256(elf_file)
+        if args.force or not read_cache(build_dir, elf_hash, args.top):
+            write_reports(build_dir, analyze(elf_file, map_file), elf_hash, args.top)
+    except OSError as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    for index, key in enumerate(PRINT_CHOICES[args.print_report]):
+        if index:
+            print("")
+        sys.stdout.write((build_dir / REPORT_FILES[key]).read_text())
+
+if __name__ == '__main__':
+    main()